@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <Networking/EventLoop.h>
+#include <Networking/Networking.h>
+
+// Round trips between many agents and one event loop, to compare the backends under the same load.
+// Every agent sends a frame and waits for the echo before sending the next, like an agent answering probes.
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        EventLoopBackend backend = EventLoopBackend::Epoll;
+        size_t agents = 200;
+        size_t seconds = 5;
+        size_t payload = 256;
+    };
+
+    bool ParseCount(const std::string_view argument, const std::string_view prefix, size_t &out) {
+        const std::string_view value = argument.substr(prefix.size());
+        const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), out);
+        return error == std::errc{} && end == value.data() + value.size() && out > 0;
+    }
+
+    /// \brief Opens a listener on an ephemeral loopback port and returns it with the port it got.
+    SOCKET OpenListener(uint16_t &port) {
+        const SOCKET listener = socket(AF_INET, SOCK_STREAM, 0);
+        if (listener == INVALID_SOCKET) {
+            throw std::runtime_error("Socket creation failed.");
+        }
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = 0;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t size = sizeof(address);
+        if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == SOCKET_ERROR ||
+            listen(listener, SOMAXCONN) == SOCKET_ERROR ||
+            getsockname(listener, reinterpret_cast<sockaddr *>(&address), &size) == SOCKET_ERROR) {
+            closesocket(listener);
+            throw std::runtime_error("Listen failed.");
+        }
+        port = ntohs(address.sin_port);
+        return listener;
+    }
+
+    /// \brief One agent: connects, then sends and waits for the echo until `stop`. Latencies go to `latencies`.
+    void RunAgent(const uint16_t port, const std::string &payload, const std::atomic<bool> &start,
+                  const std::atomic<bool> &stop, std::vector<Clock::duration> &latencies) {
+        const SOCKET agent = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (agent == INVALID_SOCKET ||
+            connect(agent, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == SOCKET_ERROR) {
+            std::cerr << "Agent failed to connect\n";
+            return;
+        }
+
+        while (!start.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        FrameBuffer buffer;
+        std::string_view frame;
+        while (!stop.load(std::memory_order_relaxed)) {
+            const auto sent_at = Clock::now();
+            if (SendData(agent, payload) != DataStatus::DataSent ||
+                RecvData(agent, buffer, frame) != DataStatus::DataReceived) {
+                break;
+            }
+            latencies.push_back(Clock::now() - sent_at);
+        }
+        closesocket(agent);
+    }
+
+    double Microseconds(const Clock::duration duration) {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    }
+}
+
+int main(int argc, char *argv[]) {
+    // Usage: bench [--backend=epoll|io_uring] [--agents=<count>] [--seconds=<count>] [--payload=<bytes>]
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view argument = argv[i];
+        if (argument.starts_with("--backend=")) {
+            const auto parsed = ParseEventLoopBackend(argument.substr(std::string_view("--backend=").size()));
+            if (!parsed) {
+                std::cerr << "Unknown backend: " << argument << "\n";
+                return 1;
+            }
+            options.backend = *parsed;
+        } else if (!(argument.starts_with("--agents=") && ParseCount(argument, "--agents=", options.agents)) &&
+                   !(argument.starts_with("--seconds=") && ParseCount(argument, "--seconds=", options.seconds)) &&
+                   !(argument.starts_with("--payload=") && ParseCount(argument, "--payload=", options.payload))) {
+            std::cerr << "Invalid argument: " << argument << "\n";
+            return 1;
+        }
+    }
+
+#if _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        std::cerr << "WSAStartup failed.\n";
+        return 1;
+    }
+#endif
+
+    uint16_t port = 0;
+    const SOCKET listener = OpenListener(port);
+    const auto event_loop = EventLoop::Create(options.backend);
+    EventLoop &loop = *event_loop;
+    EventLoop::Handlers handlers;
+    handlers.on_frame = [&loop](const std::shared_ptr<Connection> &connection, const std::string_view frame) {
+        loop.Send(connection, std::string(frame));
+    };
+    loop.Start(std::move(handlers));
+    loop.Listen(listener);
+
+    const std::string payload(options.payload, 'x');
+    std::atomic<bool> start{false};
+    std::atomic<bool> stop{false};
+    std::vector<std::vector<Clock::duration> > latencies(options.agents);
+    std::vector<std::thread> agents;
+    agents.reserve(options.agents);
+    for (size_t agent = 0; agent < options.agents; ++agent) {
+        agents.emplace_back(RunAgent, port, std::cref(payload), std::cref(start), std::cref(stop),
+                            std::ref(latencies[agent]));
+    }
+
+    const auto started_at = Clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::seconds(options.seconds));
+    stop.store(true, std::memory_order_relaxed);
+    for (auto &agent: agents) {
+        agent.join();
+    }
+    const auto elapsed = Clock::now() - started_at;
+
+    loop.Stop();
+    closesocket(listener);
+    WSACleanup();
+
+    std::vector<Clock::duration> all;
+    for (const auto &agent: latencies) {
+        all.insert(all.end(), agent.begin(), agent.end());
+    }
+    if (all.empty()) {
+        std::cerr << "No round trips completed\n";
+        return 1;
+    }
+    std::ranges::sort(all);
+    const auto percentile = [&all](const double fraction) {
+        return Microseconds(all[std::min(all.size() - 1, static_cast<size_t>(fraction * all.size()))]);
+    };
+
+    std::cout << "backend:     " << loop.Name() << " (" << loop.WorkerCount() << " workers)\n"
+              << "agents:      " << options.agents << ", payload " << options.payload << " bytes\n"
+              << "round trips: " << all.size() << " ("
+              << static_cast<size_t>(all.size() / std::chrono::duration<double>(elapsed).count()) << "/s)\n"
+              << "latency us:  p50 " << percentile(0.5) << ", p99 " << percentile(0.99)
+              << ", max " << Microseconds(all.back()) << "\n";
+    return 0;
+}
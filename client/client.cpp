@@ -1,6 +1,8 @@
 #include "client.h"
 
+#include <Actions/Action.h>
 #include <Actions/ActionStructures.h>
+#include <Actions/ResultCache.h>
 #include <SystemManager/OperatingSystemManager.h>
 
 #include "RequestBuilder/RequestBuilder.h"
@@ -22,11 +24,14 @@ void Client::InitializeConnection() {
     server_addr.sin_family = AF_INET;
     server_addr.sin_port = htons(PORT);
     inet_pton(AF_INET, "127.0.0.1", &server_addr.sin_addr);
+
+    network_watcher.Start([] { ResultCache::Invalidate(CacheTopic::Network); });
+    timers.Schedule(std::chrono::steady_clock::now() + STATUS_CHECK_INTERVAL, [this] { CheckStatus(); });
 }
 
 // ----------------------------------========Helper Functions========---------------------------------- //
 // Helper: Parse JSON from received buffer
-std::optional<json> Client::ParseJson(const std::string &buffer) {
+std::optional<json> Client::ParseJson(const std::string_view buffer) {
     try {
         return json::parse(buffer);
     } catch (const json::parse_error &) {
@@ -35,53 +40,51 @@ std::optional<json> Client::ParseJson(const std::string &buffer) {
     }
 }
 
-// Helper: Attempt to reconnect
+// Helper: Attempt to reconnect. A socket can only be connected once, so every attempt starts from a fresh one.
 bool Client::AttemptReconnect() {
-    while (connect(server_socket, reinterpret_cast<sockaddr *>(&server_addr), sizeof(server_addr)) == SOCKET_ERROR) {
-        std::cerr << "Connection failed. Retrying...\n";
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+    std::mt19937 random(std::random_device{}());
+    std::chrono::milliseconds delay = RECONNECT_DELAY_MIN;
+    while (true) {
+        {
+            std::lock_guard lock(send_mutex);
+            if (server_socket != INVALID_SOCKET) {
+                closesocket(server_socket);
+            }
+            ++connection_generation;
+            server_socket = socket(AF_INET, SOCK_STREAM, 0);
+        }
+        recv_buffer.Clear();
+
+        if (server_socket != INVALID_SOCKET &&
+            connect(server_socket, reinterpret_cast<sockaddr *>(&server_addr), sizeof(server_addr)) != SOCKET_ERROR) {
+            return true;
+        }
+        // Half the delay is random, so clients cut off together do not all come back at the same moment.
+        const auto wait = delay / 2 + std::chrono::milliseconds(
+                              std::uniform_int_distribution<int64_t>{0, delay.count() / 2}(random));
+        std::cerr << "Connection failed. Retrying in " << wait.count() << " ms...\n";
+        if (!timers.WaitUntil(std::chrono::steady_clock::now() + wait)) {
+            return false;
+        }
+        delay = std::min<std::chrono::milliseconds>(delay * 2, RECONNECT_DELAY_MAX);
     }
-    return true;
 }
 
-// Helper: Send client ID to the server.
-bool Client::SendClientId() {
+// Helper: Send client ID to the server and wait for its single Ok/Incorrect reply.
+// Returns std::nullopt if the connection broke and has to be re-established.
+std::optional<ClientIdErrorType> Client::SendClientId() {
 #ifdef _ADMIN
     // Send password and login to server with id
     Request request;
     request.InitializeRequest("AdminCredential", AdminCredentialS{}, &id);
-    std::string buffer(1024, 0);
-    switch (SendData(server_socket, request.body)) {
-        case DataStatus::DataSent:
-            std::cout << "Admin credentials sent to the server.\n";
-            switch (RecvData(server_socket, buffer)) {
-                case DataStatus::DataReceived: {
-                    const auto errorType = ProcessServerResponse(buffer);
-                    if (errorType.value() == Ok) {
-                        return true;
-                    }
-
-                    std::cerr << "Incorrect Admin credentials. Reconnecting...\n";
-                    return false;
-                }
-                case DataStatus::DataNotReceived:
-                    std::cerr << "No data received. Reconnecting...\n";
-                    return false;
-                case DataStatus::UnknownReceivedError:
-                    std::cerr << "Unknown error while receiving data. Reconnecting...\n";
-                    return false;
-                default:
-                    std::cerr << "Unknown error while receiving data. Reconnecting...\n";
-            };
-            return true;
-
-        case DataStatus::DataNotSent:
-        case DataStatus::UnknownSentError:
-            std::cerr << "Failed to send Admin credentials. Reconnecting...\n";
-            return AttemptReconnect();
-        default: break;
-    };
-
+    json credentials = request.message;
+    credentials["codecs"] = CodecOffer();
+    credentials["opcodes"] = true;
+    if (SendData(server_socket, credentials) != DataStatus::DataSent) {
+        std::cerr << "Failed to send Admin credentials. Reconnecting...\n";
+        return std::nullopt;
+    }
+    std::cout << "Admin credentials sent to the server.\n";
 #else
     std::cout << "Client auto gen id: " << id << "\n";
 
@@ -96,46 +99,40 @@ bool Client::SendClientId() {
         id = std::stoull(id_str);
     }
 
-    const std::string id_message = "{\"id\":" + std::to_string(id) + "}";
-
-    std::string buffer(1024, 0);
-    switch (SendData(server_socket, id_message)) {
-        case DataStatus::DataSent:
-            std::cout << id << ":ID sent to the server.\n";
-            switch (RecvData(server_socket, buffer)) {
-                case DataStatus::DataReceived: {
-                    const auto errorType = ProcessServerResponse(buffer);
-                    if (errorType.value() == Ok) {
-                        return true;
-                    }
-
-                    std::cerr << "Incorrect client ID. Reconnecting...\n";
-                    return false;
-                }
-                case DataStatus::DataNotReceived:
-                    std::cerr << "No data received. Reconnecting...\n";
-                    return false;
-                case DataStatus::UnknownReceivedError:
-                    std::cerr << "Unknown error while receiving data. Reconnecting...\n";
-                    return false;
-                default: break;
-            };
-
-            return true;
-
-        case DataStatus::DataNotSent:
-        case DataStatus::UnknownSentError:
-            std::cerr << "Failed to send ID. Reconnecting...\n";
-            return AttemptReconnect();
-        default: break;
+    const json id_message = {{"id", id}, {"codecs", CodecOffer()}, {"opcodes", true}};
+    if (SendData(server_socket, id_message) != DataStatus::DataSent) {
+        std::cerr << "Failed to send ID. Reconnecting...\n";
+        return std::nullopt;
     }
+    std::cout << id << ":ID sent to the server.\n";
 #endif
 
-    return false;
+    // The handshake is always JSON; the server's reply names the codec for everything after it.
+    codec = Codec::Json;
+    std::string_view frame;
+    switch (RecvData(server_socket, recv_buffer, frame)) {
+        case DataStatus::DataReceived:
+            return ProcessServerResponse(frame);
+        case DataStatus::DataNotReceived:
+        case DataStatus::ConnectionClosed:
+            std::cerr << "No data received. Reconnecting...\n";
+            return std::nullopt;
+        default:
+            std::cerr << "Unknown error while receiving data. Reconnecting...\n";
+            return std::nullopt;
+    }
+}
+
+json Client::CodecOffer() const {
+    json names = json::array();
+    for (const Codec offered: offered_codecs) {
+        names.push_back(CodecName(offered));
+    }
+    return names;
 }
 
 // Helper: Process the server response
-std::optional<ClientIdErrorType> Client::ProcessServerResponse(const std::string &buffer) {
+std::optional<ClientIdErrorType> Client::ProcessServerResponse(const std::string_view buffer) {
     auto parsed_json = ParseJson(buffer);
     if (!parsed_json) {
         return std::nullopt;
@@ -143,6 +140,13 @@ std::optional<ClientIdErrorType> Client::ProcessServerResponse(const std::string
 
     try {
         int error_type = parsed_json->at("error_type").get<int>();
+        // Servers that do not negotiate leave the codec out and stay on JSON.
+        if (const auto name = parsed_json->find("codec"); name != parsed_json->end() && name->is_string()) {
+            codec = ParseCodec(name->get<std::string>()).value_or(Codec::Json);
+        }
+        // Likewise without an opcode table, actions stay named.
+        const auto opcodes = parsed_json->find("opcodes");
+        actionManager.setOpcodes(opcodes != parsed_json->end() && opcodes->is_array() ? *opcodes : json::array());
         return static_cast<ClientIdErrorType>(error_type);
     } catch (const json::out_of_range &) {
         std::cerr << "Invalid response from server.\n";
@@ -159,100 +163,281 @@ void Client::HandleIdError(const ClientIdErrorType errorType) {
             break;
 
         case Ok:
-            std::cout << "Client ID is correct.\n";
+            std::cout << "Client ID is correct. Using " << CodecName(codec) << " codec.\n";
             break;
     }
 }
 
-// Main connection function
-void Client::TryToConnect() {
-    bool is_info_send = false;
+// Main connection function. Returns once the server has accepted the id; the caller keeps reading commands.
+bool Client::TryToConnect() {
+    if (!AttemptReconnect()) {
+        return false;
+    }
 
-    while (!is_info_send) {
-        AttemptReconnect();
+    while (true) {
+        const auto errorType = SendClientId();
+        if (errorType == Ok) {
+            HandleIdError(Ok);
+            std::lock_guard lock(send_mutex);
+            identified_generation = connection_generation;
+            return true;
+        }
+        if (errorType == Incorrect) {
+#ifdef _ADMIN
+            std::cerr << "Incorrect Admin credentials. Reconnecting...\n";
+            if (!timers.WaitUntil(std::chrono::steady_clock::now() + RECONNECT_DELAY_MIN) || !AttemptReconnect()) {
+                return false;
+            }
+#else
+            // The server keeps the connection open, so a new id is offered on the same socket.
+            HandleIdError(Incorrect);
+#endif
+            continue;
+        }
+        if (!AttemptReconnect()) {
+            return false;
+        }
+    }
+}
 
-        // Try to send the client ID
-        if (SendClientId()) {
-            is_info_send = true;
+// This function will be used for handling messages from the server...
+void Client::WaitingForCommands() {
+    while (true) {
+        std::string_view frame;
+        if (RecvData(server_socket, recv_buffer, frame) == DataStatus::DataReceived) {
+            DoAction(frame);
+        } else {
+            std::cerr << "Connection lost.\n";
+            if (!TryToConnect()) {
+                return;
+            }
         }
     }
+}
+
+void Client::DoAction(const std::string_view data) {
+    // Only the routing fields are read here; the request data is decoded by the action that needs it.
+    const auto envelope = PeekEnvelope(data, codec);
+    if (!envelope) {
+        std::cerr << "Error: Malformed " << CodecName(codec) << " frame\n";
+        return;
+    }
+    if (envelope->opcode == NAMED_OPCODE && envelope->index == STATUS_ACK) {
+        OnStatusAck(*envelope);
+        return;
+    }
+    if (envelope->opcode == NAMED_OPCODE && envelope->index == BATCH_REQUEST) {
+        DoBatch(*envelope);
+        return;
+    }
 
-    bool is_connected = false;
+    // Pooled: a repeated action reuses the instance the previous request left behind.
+    ActionLease action;
+    try {
+        // Opcodes index straight into the table agreed at the handshake.
+        action = envelope->opcode != NAMED_OPCODE
+                     ? actionManager.acquireActionByOpcode(envelope->opcode)
+                     : actionManager.acquireActionByName(envelope->index);
+        std::cout << "Client Received: " << action->getName() << " (transaction " << envelope->transaction_id
+                << ")\n";
+        if (action->requires_data_in) {
+            if (envelope->body == BinaryBody::Fields) {
+                BinaryReader reader(envelope->data.value_or(std::string_view{}));
+                action->initializeFromFields(reader);
+            } else {
+                action->initialize(envelope->DecodeData());
+            }
+        }
+    } catch (const std::exception &e) {
+        // The server still gets an answer with no result, as before.
+        std::cerr << "Error: " << e.what() << "\n";
+        action.reset();
+    }
 
-    while (!is_connected) {
-        std::string buffer(1024, '\0');
+    // Only the receiving thread changes the generation, so no lock is needed to read it here.
+    const uint64_t transaction_id = envelope->transaction_id;
+    const uint16_t opcode = envelope->opcode;
+    const uint64_t generation = connection_generation;
+    if (!action) {
+        SendResult(nullptr, transaction_id, opcode, envelope->index, codec, generation);
+        return;
+    }
 
-        switch (RecvData(server_socket, buffer)) {
-            case DataStatus::DataReceived: {
-                std::cout << "Received: " << buffer << "\n";
-                const auto errorType = ProcessServerResponse(buffer);
+    // A long action must not hold up the requests behind it, so it runs on a worker and answers from there.
+    // Results may overtake each other; the server matches them by transaction id.
+    const bool is_queued = actionManager.executeAsync(
+        std::move(action), [this, transaction_id, opcode, result_codec = codec, generation](Action &running) {
+            SendResult(&running, transaction_id, opcode, running.getName(), result_codec, generation);
+        });
+    if (!is_queued) {
+        std::cerr << "Error: Action queue is full, transaction " << transaction_id << " rejected\n";
+        SendResult(nullptr, transaction_id, opcode, envelope->index, codec, generation);
+    }
+}
 
-                if (errorType) {
-                    HandleIdError(errorType.value());
-                }
-                is_connected = true;
-            }
+void Client::DoBatch(const MessageEnvelope &envelope) {
+    const uint64_t transaction_id = envelope.transaction_id;
+    const uint64_t generation = connection_generation;
+    std::cout << "Client Received: " << BATCH_REQUEST << " (transaction " << transaction_id << ")\n";
+
+    // The combined response carries the same routing fields as any other; only the results differ.
+    auto send_results = [this, transaction_id, result_codec = codec, generation](json results) {
+        json response;
+        response["results"] = std::move(results);
+        response["transaction_id"] = transaction_id;
+        response["index"] = BATCH_REQUEST;
+        SendFrameIfCurrent(EncodeMessage(response, result_codec), transaction_id, generation);
+    };
 
-            case DataStatus::DataNotReceived:
-                std::cerr << "No data received. Retrying...\n";
-                std::this_thread::sleep_for(std::chrono::milliseconds(500));
-                break;
-
-            case DataStatus::UnknownReceivedError:
-                std::cerr << "Unknown error while receiving data. Reconnecting...\n";
-                if (!AttemptReconnect()) {
-                    is_connected = true;
-                }
-                break;
-            default: break;
+    json batch;
+    try {
+        batch = envelope.DecodeData();
+        if (!batch.contains("actions") || !batch.at("actions").is_array()) {
+            throw std::invalid_argument("Batch has no actions");
         }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        send_results(json::array());
+        return;
     }
-
-    receiveThread = std::thread(&Client::WaitingForCommands, this);
+    actionManager.executeActions(batch, std::move(send_results));
 }
 
-// This function will be used for handling messages from the server...
-void Client::WaitingForCommands() {
-    while (true) {
-        const int bytesReceived = recv(server_socket, buffer, BUFFER_SIZE, 0);
-        if (bytesReceived > 0) {
-            std::string data(buffer, bytesReceived);
-            std::cout << "Client Received: " << data << "\n";
-            DoAction(data);
-            memset(buffer, 0, BUFFER_SIZE);
-        } else if (bytesReceived == SOCKET_ERROR) {
-            std::cerr << "Connection lost.\n";
-            TryToConnect();
+void Client::SendResult(Action *action, const uint64_t transaction_id, const uint16_t opcode,
+                        const std::string_view index, const Codec result_codec, const uint64_t generation) {
+    // One buffer per thread, which keeps its capacity between responses.
+    thread_local std::string send_buffer;
+    send_buffer.clear();
+    if (result_codec == Codec::Binary) {
+        BinaryWriter writer(send_buffer);
+        if (action) {
+            action->executeToFields(writer, transaction_id, opcode);
+        } else {
+            WriteEnvelope(writer, transaction_id, opcode, index, BinaryBody::Empty);
         }
+    } else {
+        json result{};
+        if (action) {
+            action->execute([&result](const json &res) { result = res; });
+        }
+        // The answer names the action the same way the request did.
+        result["transaction_id"] = transaction_id;
+        if (opcode != NAMED_OPCODE) {
+            result["index"] = opcode;
+        } else {
+            result["index"] = index;
+        }
+        send_buffer = EncodeMessage(result, result_codec);
     }
+
+    SendFrameIfCurrent(send_buffer, transaction_id, generation);
 }
 
-void Client::DoAction(const std::string &data) {
-    const nlohmann::json json_data = nlohmann::json::parse(data);
+void Client::SendFrameIfCurrent(const std::string &frame, const uint64_t transaction_id, const uint64_t generation) {
+    std::lock_guard lock(send_mutex);
+    if (generation != connection_generation) {
+        // Requested on a connection that is gone; the server has already failed the request.
+        return;
+    }
+    size_t bytes_written = 0;
+    if (!SendFrame(server_socket, frame, bytes_written)) {
+        std::cerr << "Error: Failed to send the result of transaction " << transaction_id << "\n";
+    }
+}
 
-    if (json_data.empty()) {
-        std::cerr << "Error: Invalid JSON data\n";
+void Client::CheckStatus() {
+    // Runs on the timer thread, which must not block, so the status is collected on an action worker.
+    // Each check schedules the next one when it is done, so checks never overlap.
+    auto schedule_next = [this] {
+        timers.Schedule(std::chrono::steady_clock::now() + STATUS_CHECK_INTERVAL, [this] { CheckStatus(); });
+    };
+    ActionLease status_action;
+    try {
+        status_action = actionManager.acquireActionByName(GetClientStatus::NAME);
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        schedule_next();
         return;
     }
-    if (!json_data.contains("index")) {
-        std::cerr << "Error: Invalid JSON data\n";
+    const bool is_queued = actionManager.executeAsync(std::move(status_action), [this, schedule_next](Action &running) {
+        std::optional<PCStatus_S_OUT> status;
+        running.execute([&status](const json &result) {
+            // A failed collection leaves an empty result.
+            if (result.is_object()) {
+                status = result.get<PCStatus_S_OUT>();
+            }
+        });
+        PushStatus(status);
+        schedule_next();
+    });
+    if (!is_queued) {
+        // The workers are busy with requests; the status can wait for the next check.
+        schedule_next();
+    }
+}
+
+void Client::PushStatus(const std::optional<PCStatus_S_OUT> &status) {
+    std::lock_guard lock(send_mutex);
+    if (identified_generation != connection_generation) {
+        // Not connected, or the handshake on this connection has not finished.
         return;
     }
-    if (!json_data.contains("transaction_id")) {
-        std::cerr << "Error: Invalid JSON data\n";
+
+    const auto now = std::chrono::steady_clock::now();
+    const bool is_new_connection = sent_generation != connection_generation;
+    json message;
+    message["transaction_id"] = 0;
+    // A failed collection yields no status; the server then only hears that the agent is alive.
+    if (status && (is_new_connection || !is_awaiting_ack) &&
+        (is_new_connection || acked_version == 0 || ChangedFields(acked_status, *status) != 0)) {
+        const uint64_t changed = acked_version == 0 ? ~uint64_t{0} : ChangedFields(acked_status, *status);
+        sent_status = *status;
+        sent_generation = connection_generation;
+        is_awaiting_ack = true;
+        message["index"] = STATUS_PUSH;
+        message["data"] = {
+            {"version", ++sent_version},
+            {"base", acked_version},
+            {"fields", FieldsToJson(*status, changed)}
+        };
+    } else if (now - last_push >= HEARTBEAT_INTERVAL) {
+        message["index"] = HEARTBEAT;
+    } else {
         return;
     }
+    last_push = now;
 
-    json result = actionManager.executeAction(json_data);
+    // The handshake set the codec before identified_generation caught up, so it is settled by now.
+    size_t bytes_written = 0;
+    if (!SendFrame(server_socket, EncodeMessage(message, codec), bytes_written)) {
+        std::cerr << "Error: Failed to push " << message["index"].get<std::string>() << "\n";
+    }
+}
 
-    // Add transaction_id and index to the result
-    result["transaction_id"] = json_data.at("transaction_id");
-    result["index"] = json_data.at("index");
+void Client::OnStatusAck(const MessageEnvelope &envelope) {
+    std::optional<uint64_t> version;
+    try {
+        version = envelope.DecodeData().at("version").get<uint64_t>();
+    } catch (const std::exception &e) {
+        std::cerr << "Error: Malformed " << STATUS_ACK << ": " << e.what() << "\n";
+    }
 
-    SendData(server_socket, result);
+    std::lock_guard lock(send_mutex);
+    if (!is_awaiting_ack) {
+        return;
+    }
+    is_awaiting_ack = false;
+    if (version == sent_version) {
+        acked_status = sent_status;
+        acked_version = sent_version;
+    } else {
+        // The push did not fit the server's record, e.g. because the server restarted: the next one is whole.
+        acked_version = 0;
+    }
 }
 
 void Client::StopConnection() {
+    timers.Stop();
     closesocket(server_socket);
     WSACleanup();
     if (receiveThread.joinable()) {
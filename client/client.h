@@ -1,9 +1,13 @@
 #pragma once
+#include <mutex>
 #include <thread>
 #include <random>
 
 #include <Actions/ActionSystem.h>
 #include <Networking/Networking.h>
+#include <Networking/Envelope.h>
+#include <SystemManager/NetworkWatcher.h>
+#include <Timing/TimerThread.h>
 
 
 class Client {
@@ -11,16 +15,47 @@ public:
     ~Client() = default;
 
     static constexpr int PORT = 54000;
-    static constexpr int BUFFER_SIZE = 1024;
+
+    /// \brief Wait after the first failed connect; it doubles with every failure up to the maximum.
+    static constexpr auto RECONNECT_DELAY_MIN = std::chrono::milliseconds(500);
+    static constexpr auto RECONNECT_DELAY_MAX = std::chrono::seconds(30);
+
+    /// \brief How often the status is collected and compared with what the server was last sent.
+    static constexpr auto STATUS_CHECK_INTERVAL = std::chrono::seconds(5);
 
 #if _WIN32
     WSADATA wsaData{};
 #endif
 
     sockaddr_in server_addr{};
-    SOCKET server_socket{};
+    SOCKET server_socket = INVALID_SOCKET;
+
+    FrameBuffer recv_buffer;
+
+    /// \brief Serializes results from the action workers onto the socket. Also guards swapping the socket
+    /// on reconnect, together with connection_generation.
+    std::mutex send_mutex;
+
+    /// \brief Bumped on every reconnect, so results of requests from an earlier connection are dropped.
+    uint64_t connection_generation = 0;
 
-    char buffer[BUFFER_SIZE]{};
+    /// \brief connection_generation once the server has accepted the id on it. Nothing is pushed before.
+    uint64_t identified_generation = 0;
+
+    // Status versions (see STATUS_PUSH), guarded by send_mutex. Only one push waits for its acknowledgement
+    // at a time, so every delta is based on a version the server holds.
+    /// \brief The last status the server acknowledged and its version; 0 if the next push has to be whole.
+    PCStatus_S_OUT acked_status;
+    uint64_t acked_version = 0;
+
+    /// \brief The last status pushed, its version and the connection it went out on.
+    PCStatus_S_OUT sent_status;
+    uint64_t sent_version = 0;
+    uint64_t sent_generation = 0;
+    bool is_awaiting_ack = false;
+
+    /// \brief When the last push or heartbeat went out.
+    std::chrono::steady_clock::time_point last_push{};
 
     std::thread receiveThread;
     std::thread thread_send;
@@ -29,25 +64,62 @@ public:
     ActionFactory actionFactory{};
     ActionManager actionManager{actionFactory};
 
+    /// \brief Invalidates cached network data (see ResultCache) when interfaces or addresses change.
+    NetworkWatcher network_watcher;
+
+    /// \brief Reconnect backoff and status checks. Stopping it ends a reconnect that is waiting.
+    TimerThread timers;
+
     size_t id = 0;
 
+    /// \brief Codecs offered in the handshake, best first, and the one the server picked.
+    std::vector<Codec> offered_codecs = DefaultCodecPreference();
+    Codec codec = Codec::Json;
+
     void InitializeConnection();
 
-    std::optional<json> ParseJson(const std::string &buffer);
+    std::optional<json> ParseJson(std::string_view buffer);
 
+    /// \brief Connects a fresh socket, backing off exponentially with jitter between attempts. Returns false
+    /// if the client is stopped while waiting.
     bool AttemptReconnect();
 
-    bool SendClientId();
+    std::optional<ClientIdErrorType> SendClientId();
+
+    json CodecOffer() const;
 
-    std::optional<ClientIdErrorType> ProcessServerResponse(const std::string &buffer);
+    std::optional<ClientIdErrorType> ProcessServerResponse(std::string_view buffer);
 
     void HandleIdError(ClientIdErrorType errorType);
 
-    void TryToConnect();
+    /// \brief Connects and identifies to the server. Returns false if the client is stopped first.
+    bool TryToConnect();
 
     void WaitingForCommands();
 
-    void DoAction(const std::string &data);
+    void DoAction(std::string_view data);
+
+    /// \brief Runs a BATCH_REQUEST and answers it once, with every result.
+    void DoBatch(const MessageEnvelope &envelope);
+
+    /// \brief Encodes the result of `action`, or an empty result when it is null, and sends it unless the
+    /// connection it was requested on is gone. Safe to call from any thread.
+    void SendResult(Action *action, uint64_t transaction_id, uint16_t opcode, std::string_view index,
+                    Codec result_codec, uint64_t generation);
+
+    /// \brief Sends an encoded response unless the connection it was requested on is gone.
+    void SendFrameIfCurrent(const std::string &frame, uint64_t transaction_id, uint64_t generation);
+
+    /// \brief Collects the status on an action worker and pushes it, then schedules the next check.
+    void CheckStatus();
+
+    /// \brief Pushes the fields of `status` that changed since the version the server acknowledged, a heartbeat
+    /// if the last push is HEARTBEAT_INTERVAL old, or nothing. Each new connection gets a push, so the server
+    /// confirms which version it holds. Safe to call from any thread.
+    void PushStatus(const std::optional<PCStatus_S_OUT> &status);
+
+    /// \brief Handles the server's STATUS_ACK.
+    void OnStatusAck(const MessageEnvelope &envelope);
 
     void StopConnection();
 
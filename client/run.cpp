@@ -1,11 +1,44 @@
 #include "client.h"
 
-int main()
+#include <charconv>
+
+#include <SystemManager/OperatingSystemManager.h>
+
+/// \brief Shell sessions kept for RunCommand at most; each one is an idle `sh` process.
+static constexpr size_t MAX_SHELL_SESSIONS = 16;
+
+int main(int argc, char *argv[])
 {
     Client client;
+
+    // Usage: client [--codec=binary|msgpack|cbor|json] [--shell-pool=<sessions>]
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view argument = argv[i];
+        if (argument.starts_with("--shell-pool=")) {
+            const std::string_view value = argument.substr(std::string_view("--shell-pool=").size());
+            size_t sessions = 0;
+            const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), sessions);
+            if (error != std::errc{} || end != value.data() + value.size() || sessions > MAX_SHELL_SESSIONS) {
+                std::cerr << "Invalid shell pool size: " << argument << " (0-" << MAX_SHELL_SESSIONS << ")\n";
+                return 1;
+            }
+            OperatingSystemManager::EnableShellPool(sessions);
+            continue;
+        }
+        if (argument.starts_with("--codec=")) {
+            const auto parsed = ParseCodec(argument.substr(std::string_view("--codec=").size()));
+            if (!parsed) {
+                std::cerr << "Unknown codec: " << argument << "\n";
+                return 1;
+            }
+            client.offered_codecs = {*parsed};
+        }
+    }
+
     client.InitializeConnection();
-    client.TryToConnect();
-    client.WaitingForCommands();
+    if (client.TryToConnect()) {
+        client.WaitingForCommands();
+    }
     client.StopConnection();
     return 0;
 }
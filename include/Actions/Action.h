@@ -1,5 +1,7 @@
 #pragma once
 #include <Actions/ActionSystem.h>
+#include <Actions/ActionList.h>
+#include <Actions/ResultCache.h>
 #include <SystemManager/OperatingSystemManager.h>
 #include <Actions/ActionStructures.h>
 
@@ -7,15 +9,22 @@
 class RunCommand final : public BaseAction<CmdResult_S, CmdCommand_S>
 {
 public:
-    RunCommand() : BaseAction("RunCommand", true)
+    static constexpr const char* NAME = "RunCommand";
+
+    RunCommand() : BaseAction(NAME, true)
     {
     }
 
 protected:
     CmdResult_S perform() override
     {
+        CommandOutput output = OperatingSystemManager::RunShellCommand(input_data.command);
         CmdResult_S cmd_command;
-        cmd_command.result = OperatingSystemManager::ExecuteCommand(input_data.command);
+        cmd_command.result = std::move(output.output);
+        cmd_command.error = std::move(output.errors);
+        cmd_command.exit_code = output.exit_code;
+        cmd_command.timed_out = output.timed_out;
+        cmd_command.truncated = output.truncated;
         return cmd_command;
     }
 };
@@ -23,25 +32,42 @@ protected:
 class GetClientStatus final : public BaseAction<PCStatus_S_OUT>
 {
 public:
-    GetClientStatus() : BaseAction("GetClientStatus", false)
+    static constexpr const char* NAME = "GetClientStatus";
+
+    GetClientStatus() : BaseAction(NAME, false)
     {
     }
 
+    /// \brief On Linux the status is read natively, but elsewhere collecting it spawns three external commands,
+    /// so repeated queries (e.g. from several admins) are answered from memory. Network changes invalidate the
+    /// cache before the TTL runs out.
+    static constexpr auto CACHE_TTL = std::chrono::seconds(30);
+
 protected:
     PCStatus_S_OUT perform() override
     {
-        PCStatus_S_OUT pc_status;
-        pc_status.ip = OperatingSystemManager::GetClientIP();
-        pc_status.mac = OperatingSystemManager::GetClientMAC();
-        pc_status.os = OperatingSystemManager::GetClientOS();
-        return pc_status;
+        return status_cache.Get([]
+        {
+            PCStatus_S_OUT pc_status;
+            pc_status.ip = OperatingSystemManager::GetClientIP();
+            pc_status.mac = OperatingSystemManager::GetClientMAC();
+            pc_status.os = OperatingSystemManager::GetClientOS();
+            return pc_status;
+        });
     }
+
+private:
+    inline static CachedResult<PCStatus_S_OUT> status_cache{CACHE_TTL, {CacheTopic::Network}};
 };
 
 class IsClientUp final : public BaseAction<IsClientUp_S>
 {
 public:
-    IsClientUp() : BaseAction("IsClientUp", false){}
+    static constexpr const char* NAME = "IsClientUp";
+
+    IsClientUp() : BaseAction(NAME, false){}
+
+    bool runsInline() const override { return true; }
 protected:
     IsClientUp_S perform() override
     {
@@ -50,7 +76,11 @@ protected:
 };
 // ------------------------------ Actions Registration ------------------------------ //
 
-//!TODO: Register all actions here
+/// \brief Every action of this build. Registered with the ActionFactory and looked up by name through a
+/// compile-time perfect hash. An action's position here is also its wire opcode, so append only: existing
+/// opcodes must never change meaning.
+using RegisteredActions = ActionList<RunCommand, GetClientStatus, IsClientUp>;
+
 class ActionRegistry
 {
 public:
@@ -68,6 +98,43 @@ public:
     Actions status_update_actions = {
         std::make_shared<IsClientUp>()
     };
+
+    /// \brief One instance per opcode (see RegisteredActions). The server sends this list by name in the
+    /// handshake and the client maps it onto its own actions, after which "index" carries the opcode
+    /// instead of the name.
+    Actions opcode_table = RegisteredActions::Instantiate();
+
+    std::shared_ptr<Action> AtOpcode(const uint16_t opcode) const
+    {
+        return opcode < opcode_table.size() ? opcode_table[opcode] : nullptr;
+    }
+
+    /// \brief Only for peers that name their actions; everything else goes by opcode.
+    std::optional<uint16_t> OpcodeOf(const std::string_view name) const
+    {
+        if (const auto index = RegisteredActions::IndexOf(name))
+        {
+            return static_cast<uint16_t>(*index);
+        }
+        return std::nullopt;
+    }
+
+    /// \brief Any registered action with that name.
+    std::shared_ptr<Action> Find(const std::string_view name) const
+    {
+        const auto opcode = OpcodeOf(name);
+        return opcode ? AtOpcode(*opcode) : nullptr;
+    }
+
+    json OpcodeNames() const
+    {
+        json names = json::array();
+        for (const auto& action : opcode_table)
+        {
+            names.push_back(action->getName());
+        }
+        return names;
+    }
 };
 
 inline ActionRegistry action_registry;
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "ActionSystem.h"
+
+// ----=== Compile-time action list ===----
+/// \brief FNV-1a over the name, started from `seed` so the perfect-hash search can try other functions.
+constexpr uint64_t HashActionName(const std::string_view name, const uint64_t seed) {
+    uint64_t hash = 0xcbf29ce484222325ull ^ seed;
+    for (const char c: name) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+    }
+    // The low bits of a product only depend on the low bits of its inputs; fold the high half in so that
+    // every seed bit reaches the table slot.
+    return hash ^ hash >> 32;
+}
+
+/// \brief Every action type known to this build, each with a `static constexpr const char *NAME`.
+/// \details A name is looked up with one hash, one table read and one string compare: the seed that makes
+/// the hash collision-free over all names is found at compile time. Two actions with the same name leave
+/// no such seed and fail to compile. Creating an action only constructs that one action.
+template<typename... ActionTypes>
+class ActionList {
+    template<typename T>
+    static std::shared_ptr<Action> Create() {
+        return std::make_shared<T>();
+    }
+
+    template<typename T>
+    static std::unique_ptr<Action> Allocate() {
+        return std::make_unique<T>();
+    }
+
+public:
+    using Creator = std::shared_ptr<Action> (*)();
+    using Allocator = std::unique_ptr<Action> (*)();
+
+    static constexpr size_t COUNT = sizeof...(ActionTypes);
+    static constexpr std::array<std::string_view, COUNT> NAMES{std::string_view(ActionTypes::NAME)...};
+    static constexpr std::array<Creator, COUNT> CREATORS{&Create<ActionTypes>...};
+    /// \brief Uniquely owned instances, for the ActionManager's pools.
+    static constexpr std::array<Allocator, COUNT> ALLOCATORS{&Allocate<ActionTypes>...};
+
+    /// \brief Position of the action in the list, e.g. its opcode.
+    static constexpr std::optional<size_t> IndexOf(const std::string_view name) {
+        const uint16_t entry = TABLE[HashActionName(name, SEED) & (TABLE_SIZE - 1)];
+        if (entry == 0 || NAMES[entry - 1] != name) {
+            return std::nullopt;
+        }
+        return entry - 1;
+    }
+
+    static void RegisterAll(ActionFactory &factory) {
+        (factory.registerAction<ActionTypes>(), ...);
+    }
+
+    /// \brief One instance of each action, in list order.
+    static std::vector<std::shared_ptr<Action> > Instantiate() {
+        return {std::make_shared<ActionTypes>()...};
+    }
+
+private:
+    /// \brief At least twice the number of names, so a collision-free seed turns up after a few tries.
+    static constexpr size_t TABLE_SIZE = std::bit_ceil(COUNT * 2 + 1);
+    static constexpr uint64_t MAX_SEED = 1 << 16;
+
+    static constexpr bool IsPerfect(const uint64_t seed) {
+        std::array<bool, TABLE_SIZE> is_used{};
+        for (const auto name: NAMES) {
+            bool &slot = is_used[HashActionName(name, seed) & (TABLE_SIZE - 1)];
+            if (slot) {
+                return false;
+            }
+            slot = true;
+        }
+        return true;
+    }
+
+    static constexpr uint64_t FindSeed() {
+        uint64_t seed = 0;
+        while (seed < MAX_SEED && !IsPerfect(seed)) {
+            ++seed;
+        }
+        return seed;
+    }
+
+    static constexpr uint64_t SEED = FindSeed();
+    static_assert(SEED < MAX_SEED, "Action names must be unique");
+
+    /// \brief Slot -> list position + 1; 0 marks an empty slot.
+    static constexpr std::array<uint16_t, TABLE_SIZE> TABLE = [] {
+        std::array<uint16_t, TABLE_SIZE> table{};
+        for (size_t index = 0; index < COUNT; ++index) {
+            table[HashActionName(NAMES[index], SEED) & (TABLE_SIZE - 1)] = static_cast<uint16_t>(index + 1);
+        }
+        return table;
+    }();
+};
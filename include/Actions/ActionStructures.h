@@ -1,6 +1,8 @@
 #pragma once
 #include <json/json.hpp>
 
+#include "FieldDescriptors.h"
+
 class DataStruct {
 public:
     virtual ~DataStruct() = default;
@@ -10,7 +12,7 @@ public:
 
 struct CmdCommand_S final : public DataStruct {
     std::string command;
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(CmdCommand_S, command);
+    DEFINE_DATA_STRUCT(CmdCommand_S, command);
 
     CmdCommand_S() = default;
 
@@ -20,8 +22,22 @@ struct CmdCommand_S final : public DataStruct {
 };
 
 struct CmdResult_S final : public DataStruct {
+    /// \brief What the command wrote to stdout.
     std::string result;
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(CmdResult_S, result);
+
+    /// \brief What the command wrote to stderr.
+    std::string error;
+
+    /// \brief Exit code, 128 + signal if it was killed, -1 if it did not start.
+    int32_t exit_code = -1;
+
+    /// \brief Killed for running past its timeout.
+    bool timed_out = false;
+
+    /// \brief Killed for writing more than the output cap; the output ends at the cap.
+    bool truncated = false;
+
+    DEFINE_DATA_STRUCT(CmdResult_S, result, error, exit_code, timed_out, truncated);
 };
 
 // ----=== PC Status STR ===----
@@ -37,12 +53,12 @@ struct PCStatus_S_OUT final : public DataStruct {
     /// \brief Operating system of the PC.
     std::string os;
 
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(PCStatus_S_OUT, ip, mac, os);
+    DEFINE_DATA_STRUCT(PCStatus_S_OUT, ip, mac, os);
 };
 
 struct IsClientUp_S final : DataStruct {
     bool is_up;
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(IsClientUp_S, is_up);
+    DEFINE_DATA_STRUCT(IsClientUp_S, is_up);
 
     explicit IsClientUp_S(const bool is_up) : is_up(is_up) {
     };
@@ -60,7 +76,7 @@ enum ClientIdErrorType {
 
 struct ErrorMessageSendingClientIdS final : public BasicDebugMessageS {
     ClientIdErrorType error_type;
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(ErrorMessageSendingClientIdS, error_type);
+    DEFINE_DATA_STRUCT(ErrorMessageSendingClientIdS, error_type);
 
     explicit ErrorMessageSendingClientIdS(const ClientIdErrorType error_type) : error_type(error_type) {
     };
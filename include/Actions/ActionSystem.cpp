@@ -1,52 +1,170 @@
 #include "ActionSystem.h"
 #include <Actions/Action.h>
 
-void ActionManager::executeActions(const nlohmann::json &request) {
-    for (const auto &action_json: request.at("actions")) {
-        try {
-            // Create the action using the factory
-            auto action = createActionFromRequest(action_json);
+// -----------------============Executor============----------------- //
+ActionExecutor::ActionExecutor(const size_t worker_count, const size_t capacity) : capacity(capacity) {
+    workers.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back(&ActionExecutor::workerLoop, this);
+    }
+}
 
-            // Extract data and initialize the data in action if required!
-            if (action->requires_data_in) {
-                action->initialize(action_json.at("data"));
+ActionExecutor::~ActionExecutor() {
+    {
+        std::lock_guard lock(mutex);
+        is_stopping = true;
+    }
+    job_available.notify_all();
+    for (auto &worker: workers) {
+        worker.join();
+    }
+}
+
+bool ActionExecutor::trySubmit(Job job) {
+    {
+        std::lock_guard lock(mutex);
+        if (queue.size() >= capacity) {
+            return false;
+        }
+        queue.push_back(std::move(job));
+    }
+    job_available.notify_one();
+    return true;
+}
+
+void ActionExecutor::workerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock lock(mutex);
+            job_available.wait(lock, [this] { return is_stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return;
             }
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        job();
+    }
+}
 
-            // Save the action to keep it alive
-            active_actions.push_back(action);
+// -----------------============Manager============----------------- //
+namespace {
+    struct BatchState {
+        std::mutex mutex;
+        json results = json::array();
+        size_t remaining = 0;
+        ActionManager::BatchCallback on_done;
+    };
 
-            // Execute the action synchronously
-            action->execute([this, action](const auto &result) {
-                //!TODO: Send result back to the server
+    json RunForBatch(Action &action) {
+        json result{};
+        action.execute([&result](const json &res) { result = res; });
+        result["index"] = action.getName();
+        return result;
+    }
+
+    // The action that finishes last hands the results over.
+    void FinishBatchAction(const std::shared_ptr<BatchState> &batch, const size_t position,
+                           std::optional<json> result) {
+        std::unique_lock lock(batch->mutex);
+        if (result) {
+            batch->results[position] = std::move(*result);
+        }
+        if (--batch->remaining == 0) {
+            lock.unlock();
+            batch->on_done(std::move(batch->results));
+        }
+    }
+}
 
-                // Remove the action from the active actions
-                std::erase(active_actions, action);
-            });
+void ActionManager::executeActions(const nlohmann::json &request, BatchCallback on_done) {
+    const auto &actions_json = request.at("actions");
+    const bool is_sequential = request.value("sequential", false);
+
+    const auto batch = std::make_shared<BatchState>();
+    batch->on_done = std::move(on_done);
+
+    // The data is decoded here, while the request is still around; only the execution moves to the workers.
+    std::vector<ActionLease> actions;
+    actions.reserve(actions_json.size());
+    for (const auto &action_json: actions_json) {
+        const std::string name = action_json.value("index", std::string{});
+        batch->results.push_back({{"index", name}});
+        try {
+            ActionLease action = acquireActionByName(name);
+            if (action->requires_data_in) {
+                action->initialize(action_json.at("data"));
+            }
+            actions.push_back(std::move(action));
         } catch (const std::exception &e) {
-            // Handle invalid action (log error)
             std::cerr << "Error: " << e.what() << "\n";
+            actions.emplace_back();
         }
     }
+    batch->remaining = actions.size();
+    if (actions.empty()) {
+        batch->on_done(std::move(batch->results));
+        return;
+    }
+
+    if (is_sequential) {
+        const bool is_queued = executor.trySubmit([batch, actions = std::move(actions)]() mutable {
+            for (size_t position = 0; position < actions.size(); ++position) {
+                std::optional<json> result;
+                if (actions[position]) {
+                    result = RunForBatch(*actions[position]);
+                }
+                // Back to the pool before the next one runs.
+                actions[position].reset();
+                FinishBatchAction(batch, position, std::move(result));
+            }
+        });
+        if (!is_queued) {
+            std::cerr << "Error: Action queue is full, batch of " << batch->remaining << " action(s) rejected\n";
+            batch->on_done(std::move(batch->results));
+        }
+        return;
+    }
+
+    for (size_t position = 0; position < actions.size(); ++position) {
+        if (!actions[position]) {
+            FinishBatchAction(batch, position, std::nullopt);
+            continue;
+        }
+        const bool is_queued = executeAsync(std::move(actions[position]), [batch, position](Action &running) {
+            FinishBatchAction(batch, position, RunForBatch(running));
+        });
+        if (!is_queued) {
+            std::cerr << "Error: Action queue is full, batch action " << position << " rejected\n";
+            FinishBatchAction(batch, position, std::nullopt);
+        }
+    }
+}
+
+bool ActionManager::executeAsync(ActionLease action, ActionJob job) {
+    if (action->runsInline()) {
+        job(*action);
+        return true;
+    }
+    return executor.trySubmit([action = std::move(action), job = std::move(job)]() mutable {
+        job(*action);
+    });
 }
 
 json ActionManager::executeAction(const nlohmann::json &action_json) {
     try {
-        // Create the action using the factory
-        auto action = createActionFromRequest(action_json);
+        // Check the action out of its pool; the lease keeps it in the active set until it is done
+        const ActionLease action = acquireActionByName(action_json.at("index").get<std::string>());
 
         // Extract data and initialize the data in action if required!
         if (action->requires_data_in) {
             action->initialize(action_json.at("data"));
         }
 
-        // Save the action to keep it alive
-        active_actions.push_back(action);
         // Execute the action synchronously
         json result{};
-        action->execute([this, action,&result](const json &res) {
-            // Remove the action from the active actions
-            std::erase(active_actions, action);
-
+        action->execute([&result](const json &res) {
             result = res;
         });
         return result;
@@ -58,22 +176,66 @@ json ActionManager::executeAction(const nlohmann::json &action_json) {
 }
 
 std::shared_ptr<Action> ActionManager::createActionFromRequest(const nlohmann::json &actionData) const {
-    const std::string actionType = actionData.at("index").get<std::string>();
+    return createActionByName(actionData.at("index").get<std::string>());
+}
+
+std::shared_ptr<Action> ActionManager::createActionByName(const std::string_view actionType) const {
+    if (const auto index = RegisteredActions::IndexOf(actionType)) {
+        return RegisteredActions::CREATORS[*index]();
+    }
 
-    // Interate over all reg. the Actions classes
-    for (const auto &actionCreator: factory->actionRegistry | std::views::values) {
-        auto action = actionCreator();
-        if (action->getName() == actionType) {
-            return action;
+    throw std::runtime_error("Unknown action type: " + std::string(actionType));
+}
+
+void ActionManager::setOpcodes(const nlohmann::json &names) {
+    opcode_pools.assign(names.size(), NAMED_OPCODE);
+    for (size_t opcode = 0; opcode < names.size(); ++opcode) {
+        if (!names[opcode].is_string()) {
+            continue;
         }
+        if (const auto index = RegisteredActions::IndexOf(names[opcode].get_ref<const std::string &>())) {
+            opcode_pools[opcode] = static_cast<uint16_t>(*index);
+        }
+    }
+}
+
+ActionLease ActionManager::acquireActionByName(const std::string_view actionType) {
+    if (const auto index = RegisteredActions::IndexOf(actionType)) {
+        return acquireAction(static_cast<uint16_t>(*index));
     }
 
-    throw std::runtime_error("Unknown action type: " + actionType);
+    throw std::runtime_error("Unknown action type: " + std::string(actionType));
 }
 
-//!TODO: Add more actions here. For example, RunCommand, CaptureScreen, etc.
-void ActionManager::RegisterActions() const {
-    factory->registerAction<RunCommand>();
-    factory->registerAction<GetClientStatus>();
+ActionLease ActionManager::acquireActionByOpcode(const uint16_t opcode) {
+    if (opcode >= opcode_pools.size() || opcode_pools[opcode] == NAMED_OPCODE) {
+        throw std::runtime_error("Unknown action opcode: " + std::to_string(opcode));
+    }
+    return acquireAction(opcode_pools[opcode]);
 }
 
+ActionLease ActionManager::acquireAction(const uint16_t pool) {
+    std::lock_guard lock(actions_mutex);
+    auto action = pools[pool].acquire();
+    Action *raw = action.get();
+    const ActionHandle handle = active_actions.insert(std::move(action), pool);
+    return {this, raw, handle};
+}
+
+void ActionManager::releaseAction(const ActionHandle handle) {
+    std::lock_guard lock(actions_mutex);
+    if (auto [action, pool] = active_actions.erase(handle); action) {
+        pools[pool].release(std::move(action));
+    }
+}
+
+/// New actions are added to RegisteredActions in Action.h.
+void ActionManager::RegisterActions() {
+    RegisteredActions::RegisterAll(*factory);
+
+    pools.clear();
+    pools.reserve(RegisteredActions::COUNT);
+    for (const auto allocate: RegisteredActions::ALLOCATORS) {
+        pools.emplace_back(allocate);
+    }
+}
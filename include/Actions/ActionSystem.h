@@ -1,4 +1,7 @@
 #pragma once
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include <iostream>
 #include <typeindex>
 #include <utility>
@@ -9,9 +12,14 @@
 #include <json/json.hpp>
 
 // Multithreading
+#include <condition_variable>
+#include <deque>
 #include <future>
+#include <mutex>
+#include <thread>
 
 #include "ActionStructures.h"
+#include <Networking/BinaryCodec.h>
 
 
 using json = nlohmann::json;
@@ -34,6 +42,18 @@ public:
     virtual std::any deserialize(const json& data) = 0;
     virtual json serialize() = 0;
 
+    // Binary codec counterparts of initialize/execute/deserialize. They read and write the DataStructs
+    // through their field descriptors, so no json object is built on the way.
+    virtual void initializeFromFields(BinaryReader& reader) = 0;
+    /// \brief Performs the action and appends the whole response (envelope and result fields) to `writer`.
+    /// The envelope names the action by `opcode`, or by name for NAMED_OPCODE.
+    virtual void executeToFields(BinaryWriter& writer, uint64_t transaction_id, uint16_t opcode) = 0;
+    virtual json deserializeFields(BinaryReader& reader) = 0;
+
+    /// \brief Cheap actions that are answered on the receiving thread instead of waiting for a worker, so
+    /// probes still get through while every worker is busy with long actions.
+    virtual bool runsInline() const { return false; }
+
 public:
     bool requires_data_in;
     std::string class_name;
@@ -78,6 +98,41 @@ public:
         return data.get<OutDataType>();
     }
 
+    void initializeFromFields(BinaryReader& reader) override
+    {
+        if constexpr (!std::is_void_v<InDataType>)
+        {
+            DecodeFields(reader, input_data);
+        }
+    }
+
+    void executeToFields(BinaryWriter& writer, const uint64_t transaction_id, const uint16_t opcode) override
+    {
+        std::optional<OutDataType> result;
+        try
+        {
+            result.emplace(perform());
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error in action '" << class_name << "': " << e.what() << "\n";
+        }
+
+        WriteEnvelope(writer, transaction_id, opcode, class_name, result ? BinaryBody::Fields : BinaryBody::Empty);
+        if (result)
+        {
+            EncodeFields(writer, *result);
+        }
+    }
+
+    // Only the debug output and the in-flight completions on the server still want a json object.
+    json deserializeFields(BinaryReader& reader) override
+    {
+        OutDataType result{};
+        DecodeFields(reader, result);
+        return result;
+    }
+
     // Type in field for InDataType
     json serialize() override
     {
@@ -159,6 +214,205 @@ public:
     std::unordered_map<std::type_index, ActionCreator> actionRegistry;
 };
 
+// --- Action Pools ---
+/// \brief Idle instances of one action type. Actions are reused as they are: initialize() overwrites the
+/// whole input, and the strings and vectors in it keep their capacity.
+class ActionPool
+{
+public:
+    using Allocator = std::unique_ptr<Action> (*)();
+
+    explicit ActionPool(const Allocator allocate) : allocate(allocate)
+    {
+    }
+
+    std::unique_ptr<Action> acquire()
+    {
+        if (idle.empty())
+        {
+            return allocate();
+        }
+        auto action = std::move(idle.back());
+        idle.pop_back();
+        return action;
+    }
+
+    void release(std::unique_ptr<Action> action)
+    {
+        idle.push_back(std::move(action));
+    }
+
+private:
+    Allocator allocate;
+    std::vector<std::unique_ptr<Action>> idle;
+};
+
+/// \brief Names an entry of ActiveActions. A handle outlives its entry only as a stale value: the slot's
+/// generation no longer matches.
+struct ActionHandle
+{
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+};
+
+/// \brief Actions that are currently executing, with constant-time insert and removal.
+/// \details Slots of finished actions are reused through a free list, so the set stops allocating once it
+/// has grown to the largest number of actions running at the same time.
+class ActiveActions
+{
+public:
+    ActionHandle insert(std::unique_ptr<Action> action, const uint16_t pool)
+    {
+        if (free_slots.empty())
+        {
+            free_slots.push_back(static_cast<uint32_t>(slots.size()));
+            slots.emplace_back();
+        }
+        const uint32_t index = free_slots.back();
+        free_slots.pop_back();
+
+        Slot& slot = slots[index];
+        slot.action = std::move(action);
+        slot.pool = pool;
+        return {index, slot.generation};
+    }
+
+    Action* get(const ActionHandle handle) const
+    {
+        if (handle.slot >= slots.size() || slots[handle.slot].generation != handle.generation)
+        {
+            return nullptr;
+        }
+        return slots[handle.slot].action.get();
+    }
+
+    /// \brief Takes the action out of the set, together with the index of the pool it came from.
+    std::pair<std::unique_ptr<Action>, uint16_t> erase(const ActionHandle handle)
+    {
+        if (!get(handle))
+        {
+            return {nullptr, 0};
+        }
+        Slot& slot = slots[handle.slot];
+        ++slot.generation;
+        free_slots.push_back(handle.slot);
+        return {std::move(slot.action), slot.pool};
+    }
+
+    size_t size() const { return slots.size() - free_slots.size(); }
+
+private:
+    struct Slot
+    {
+        std::unique_ptr<Action> action;
+        uint32_t generation = 0;
+        uint16_t pool = 0;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> free_slots;
+};
+
+// --- Action Executor ---
+/// \brief Fixed set of worker threads with a bounded queue. Jobs run in queue order, but finish in any order.
+class ActionExecutor
+{
+public:
+    using Job = std::move_only_function<void()>;
+
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = 256;
+
+    static size_t DefaultWorkerCount() { return std::max(2u, std::thread::hardware_concurrency()); }
+
+    explicit ActionExecutor(size_t worker_count = DefaultWorkerCount(), size_t capacity = DEFAULT_QUEUE_CAPACITY);
+
+    /// \brief Runs the jobs still queued, then joins the workers.
+    ~ActionExecutor();
+
+    /// \brief Queues the job unless `capacity` jobs are already waiting. Never blocks.
+    bool trySubmit(Job job);
+
+private:
+    void workerLoop();
+
+    std::mutex mutex;
+    std::condition_variable job_available;
+    std::deque<Job> queue;
+    size_t capacity;
+    bool is_stopping = false;
+
+    std::vector<std::thread> workers;
+};
+
+class ActionManager;
+
+/// \brief A pooled action checked out of the ActionManager. Goes back to its pool when the lease ends.
+class ActionLease
+{
+public:
+    ActionLease() = default;
+
+    ActionLease(ActionManager* manager, Action* action, const ActionHandle handle)
+        : manager(manager), action(action), handle(handle)
+    {
+    }
+
+    ActionLease(ActionLease&& other) noexcept
+        : manager(std::exchange(other.manager, nullptr)), action(std::exchange(other.action, nullptr)),
+          handle(other.handle)
+    {
+    }
+
+    ActionLease& operator=(ActionLease&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            manager = std::exchange(other.manager, nullptr);
+            action = std::exchange(other.action, nullptr);
+            handle = other.handle;
+        }
+        return *this;
+    }
+
+    ActionLease(const ActionLease&) = delete;
+    ActionLease& operator=(const ActionLease&) = delete;
+
+    ~ActionLease() { reset(); }
+
+    void reset();
+
+    Action* operator->() const { return action; }
+    Action& operator*() const { return *action; }
+    explicit operator bool() const { return action != nullptr; }
+
+private:
+    ActionManager* manager = nullptr;
+    Action* action = nullptr;
+    ActionHandle handle;
+};
+
+/// \brief Name of the request that carries several actions in one round trip. Its data is
+/// {"sequential": bool, "actions": [{"index": name, "data": ...}, ...]} and it is answered once, with
+/// {"results": [...]} holding every action's result, tagged with its "index", in request order.
+inline constexpr std::string_view BATCH_REQUEST = "Batch";
+
+/// \brief Name of the message an agent sends unprompted when its status (PCStatus_S_OUT) changes, and once on
+/// every new connection. It has transaction_id 0 and its data is {"version": v, "base": b, "fields": {...}}:
+/// status version v, as the fields that changed since version b, which the server acknowledged earlier.
+/// Base 0 means "fields" holds the whole status. The server answers with a STATUS_ACK.
+inline constexpr std::string_view STATUS_PUSH = "StatusPush";
+
+/// \brief Name of the server's answer to a STATUS_PUSH. It has transaction_id 0 and its data is
+/// {"version": v}, the status version the server holds. Anything but the pushed version means the push did
+/// not fit the server's record, and the agent sends its whole status next.
+inline constexpr std::string_view STATUS_ACK = "StatusAck";
+
+/// \brief Name of the message, without data, that an agent sends unprompted when its status has not
+/// changed for HEARTBEAT_INTERVAL, to show it is still there.
+inline constexpr std::string_view HEARTBEAT = "Heartbeat";
+inline constexpr auto HEARTBEAT_INTERVAL = std::chrono::seconds(30);
+
 class ActionManager
 {
 public:
@@ -167,16 +421,67 @@ public:
         RegisterActions();
     }
 
-    void RegisterActions() const;
+    void RegisterActions();
+
+    using ActionJob = std::move_only_function<void(Action&)>;
+
+    using BatchCallback = std::move_only_function<void(json results)>;
 
-    void executeActions(const nlohmann::json& request);
+    /// \brief Runs the actions of a batch (see BATCH_REQUEST) on the workers: all at once, or one after the
+    /// other on a single worker if the batch is sequential. `on_done` runs once, after the last action, with
+    /// the results in request order. Actions that are unknown or could not be queued have no result.
+    void executeActions(const nlohmann::json& request, BatchCallback on_done);
+
+    /// \brief Runs `job` with the action on a worker; the action goes back to its pool afterwards.
+    /// Actions that run inline run here instead. Returns false, without running the job, when the queue is full.
+    bool executeAsync(ActionLease action, ActionJob job);
 
     json executeAction(const nlohmann::json& action_json);
 
     std::shared_ptr<Action> createActionFromRequest(const nlohmann::json& actionData) const;
 
+    std::shared_ptr<Action> createActionByName(std::string_view actionType) const;
+
+    /// \brief Maps the server's opcode table (action names by opcode) onto the registered actions.
+    /// Opcodes of actions this side does not have stay empty.
+    void setOpcodes(const nlohmann::json& names);
+
+    /// \brief Checks an action out of its type's pool. Allocates only when every instance of that type is
+    /// already in use. Throws on unknown actions, like createActionByName.
+    ActionLease acquireActionByName(std::string_view actionType);
+
+    ActionLease acquireActionByOpcode(uint16_t opcode);
+
+    /// \brief Returns a leased action to its pool. Called by ActionLease.
+    void releaseAction(ActionHandle handle);
+
 private:
+    ActionLease acquireAction(uint16_t pool);
+
     std::shared_ptr<ActionFactory> factory;
 
-    std::vector<std::shared_ptr<Action>> active_actions;
+    /// \brief One pool per entry of RegisteredActions, in list order.
+    std::vector<ActionPool> pools;
+
+    /// \brief Wire opcode -> pool, filled at the handshake. NAMED_OPCODE marks actions this side does not have.
+    std::vector<uint16_t> opcode_pools;
+
+    ActiveActions active_actions;
+
+    /// \brief Guards the pools and the active set: actions are acquired on the receiving thread and
+    /// released on the workers.
+    std::mutex actions_mutex;
+
+    /// \brief Declared last so that it is destroyed first: queued jobs still release their actions.
+    ActionExecutor executor;
 };
+
+inline void ActionLease::reset()
+{
+    if (manager)
+    {
+        manager->releaseAction(handle);
+    }
+    manager = nullptr;
+    action = nullptr;
+}
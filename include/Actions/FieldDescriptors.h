@@ -0,0 +1,185 @@
+#pragma once
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <json/json.hpp>
+#include <Networking/BinaryCodec.h>
+
+// ----=== Field descriptors ===----
+/// \brief One member of a DataStruct: its name and a pointer to it.
+template<typename Owner, typename Member>
+struct Field {
+    using owner_type = Owner;
+    using member_type = Member;
+
+    const char *name;
+    Member Owner::*pointer;
+};
+
+/// \brief Ordered compile-time list of a struct's fields. Built with DEFINE_DATA_STRUCT.
+template<typename... Fields>
+struct FieldList {
+    std::tuple<Fields...> fields;
+
+    template<typename Owner, typename Member>
+    constexpr FieldList<Fields..., Field<Owner, Member> > With(const char *name, Member Owner::*pointer) const {
+        return {std::tuple_cat(fields, std::tuple{Field<Owner, Member>{name, pointer}})};
+    }
+
+    template<typename Visitor>
+    constexpr void ForEach(Visitor &&visitor) const {
+        std::apply([&visitor](const auto &... field) { (visitor(field), ...); }, fields);
+    }
+
+    static constexpr size_t Size() { return sizeof...(Fields); }
+};
+
+#define DATA_STRUCT_FIELD(field) .With(#field, &Self::field)
+
+/// \brief Drop-in replacement for NLOHMANN_DEFINE_TYPE_INTRUSIVE that also describes the fields, so the
+/// binary codec can encode and decode the struct directly, without a json object in between.
+/// The JSON conversions stay available for the debug codec and the handshake.
+#define DEFINE_DATA_STRUCT(Type, ...)                                                                   \
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE(Type, __VA_ARGS__)                                                   \
+    static constexpr auto Fields() {                                                                    \
+        using Self = Type;                                                                              \
+        return FieldList<>{} NLOHMANN_JSON_EXPAND(NLOHMANN_JSON_PASTE(DATA_STRUCT_FIELD, __VA_ARGS__)); \
+    }
+
+template<typename T>
+concept DescribedStruct = requires { T::Fields(); };
+
+template<typename T>
+struct IsVector : std::false_type {
+};
+
+template<typename T, typename Allocator>
+struct IsVector<std::vector<T, Allocator> > : std::true_type {
+};
+
+// ----=== Encoding ===----
+/// \details Every value is written at its own width, little-endian: bool as one byte, integers and enums at
+/// their size, floating point as the bits of a double, strings and vectors with a 32-bit length prefix.
+/// Field names are not sent; both sides walk the same descriptor list.
+template<typename T>
+void EncodeValue(BinaryWriter &writer, const T &value) {
+    if constexpr (DescribedStruct<T>) {
+        EncodeFields(writer, value);
+    } else if constexpr (std::is_same_v<T, bool>) {
+        writer.PutU8(value ? 1 : 0);
+    } else if constexpr (std::is_enum_v<T>) {
+        EncodeValue(writer, static_cast<std::underlying_type_t<T> >(value));
+    } else if constexpr (std::is_integral_v<T>) {
+        writer.PutInteger(static_cast<std::make_unsigned_t<T> >(value));
+    } else if constexpr (std::is_floating_point_v<T>) {
+        writer.PutInteger(std::bit_cast<uint64_t>(static_cast<double>(value)));
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        writer.PutString(value);
+    } else if constexpr (IsVector<T>::value) {
+        writer.PutInteger(static_cast<uint32_t>(value.size()));
+        for (const auto &element: value) {
+            EncodeValue(writer, element);
+        }
+    } else {
+        static_assert(sizeof(T) == 0, "Field type has no binary encoding");
+    }
+}
+
+template<DescribedStruct T>
+void EncodeFields(BinaryWriter &writer, const T &value) {
+    T::Fields().ForEach([&](const auto &field) {
+        EncodeValue(writer, value.*field.pointer);
+    });
+}
+
+// ----=== Decoding ===----
+/// \brief Overwrites `out` in place; strings and vectors reuse the capacity they already have.
+/// Throws std::out_of_range on truncated input.
+template<typename T>
+void DecodeValue(BinaryReader &reader, T &out) {
+    if constexpr (DescribedStruct<T>) {
+        DecodeFields(reader, out);
+    } else if constexpr (std::is_same_v<T, bool>) {
+        out = reader.GetU8() != 0;
+    } else if constexpr (std::is_enum_v<T>) {
+        std::underlying_type_t<T> underlying{};
+        DecodeValue(reader, underlying);
+        out = static_cast<T>(underlying);
+    } else if constexpr (std::is_integral_v<T>) {
+        out = static_cast<T>(reader.GetInteger<std::make_unsigned_t<T> >());
+    } else if constexpr (std::is_floating_point_v<T>) {
+        out = static_cast<T>(std::bit_cast<double>(reader.GetInteger<uint64_t>()));
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        out.assign(reader.GetString());
+    } else if constexpr (IsVector<T>::value) {
+        // The length is untrusted; every element takes at least one byte, so a count the input cannot hold
+        // is refused before anything is allocated.
+        const auto size = reader.GetInteger<uint32_t>();
+        if (size > reader.Rest().size()) {
+            throw std::out_of_range("Truncated binary message");
+        }
+        out.resize(size);
+        for (auto &element: out) {
+            DecodeValue(reader, element);
+        }
+    } else {
+        static_assert(sizeof(T) == 0, "Field type has no binary decoding");
+    }
+}
+
+template<DescribedStruct T>
+void DecodeFields(BinaryReader &reader, T &out) {
+    T::Fields().ForEach([&](const auto &field) {
+        DecodeValue(reader, out.*field.pointer);
+    });
+}
+
+// ----=== Deltas ===----
+/// \brief Bit i is set if the i-th field differs between `before` and `after`.
+template<DescribedStruct T>
+uint64_t ChangedFields(const T &before, const T &after) {
+    static_assert(decltype(T::Fields())::Size() <= 64, "A field mask covers at most 64 fields");
+    uint64_t mask = 0;
+    size_t index = 0;
+    T::Fields().ForEach([&](const auto &field) {
+        if (!(before.*field.pointer == after.*field.pointer)) {
+            mask |= uint64_t{1} << index;
+        }
+        ++index;
+    });
+    return mask;
+}
+
+/// \brief The fields selected by `mask` as a json object keyed by field name.
+template<DescribedStruct T>
+nlohmann::json FieldsToJson(const T &value, const uint64_t mask) {
+    nlohmann::json fields = nlohmann::json::object();
+    size_t index = 0;
+    T::Fields().ForEach([&](const auto &field) {
+        if (mask & uint64_t{1} << index) {
+            fields[field.name] = value.*field.pointer;
+        }
+        ++index;
+    });
+    return fields;
+}
+
+/// \brief Overwrites the fields named in `fields`; the others keep their value. Throws if `fields` is not an
+/// object or a value has the wrong type, in which case `out` may be partly updated.
+template<DescribedStruct T>
+void ApplyJsonFields(const nlohmann::json &fields, T &out) {
+    if (!fields.is_object()) {
+        throw std::invalid_argument("Fields must be an object");
+    }
+    T::Fields().ForEach([&](const auto &field) {
+        if (const auto it = fields.find(field.name); it != fields.end()) {
+            it->get_to(out.*field.pointer);
+        }
+    });
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <optional>
+
+// ----=== Result cache ===----
+/// \brief What a cached result depends on. Invalidating a topic drops every result that depends on it.
+enum class CacheTopic : uint8_t {
+    /// \brief Interfaces and their addresses.
+    Network = 0
+};
+
+inline constexpr size_t CACHE_TOPIC_COUNT = 1;
+
+/// \brief Invalidation hooks for CachedResult.
+/// \details Each topic has an epoch that only counts up. A result remembers the sum of its topics' epochs
+/// when it was computed, so any invalidation since then shows up as a larger sum.
+class ResultCache {
+public:
+    static void Invalidate(const CacheTopic topic) {
+        epochs[static_cast<size_t>(topic)].fetch_add(1, std::memory_order_release);
+    }
+
+    static constexpr uint32_t Mask(const std::initializer_list<CacheTopic> topics) {
+        uint32_t mask = 0;
+        for (const auto topic: topics) {
+            mask |= 1u << static_cast<size_t>(topic);
+        }
+        return mask;
+    }
+
+    static uint64_t Epoch(const uint32_t topic_mask) {
+        uint64_t sum = 0;
+        for (size_t topic = 0; topic < CACHE_TOPIC_COUNT; ++topic) {
+            if (topic_mask & 1u << topic) {
+                sum += epochs[topic].load(std::memory_order_acquire);
+            }
+        }
+        return sum;
+    }
+
+private:
+    inline static std::array<std::atomic<uint64_t>, CACHE_TOPIC_COUNT> epochs{};
+};
+
+/// \brief The last result of an expensive action, reused until it is older than its TTL or one of its
+/// topics is invalidated.
+/// \details Callers that miss at the same time wait for one computation instead of each starting their own.
+template<typename T>
+class CachedResult {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CachedResult(const Clock::duration ttl, const std::initializer_list<CacheTopic> topics)
+        : ttl(ttl), topic_mask(ResultCache::Mask(topics)) {
+    }
+
+    template<typename Compute>
+    T Get(Compute &&compute) {
+        std::lock_guard lock(mutex);
+        const auto now = Clock::now();
+        const uint64_t epoch = ResultCache::Epoch(topic_mask);
+        if (!value || now >= expires || epoch != computed_epoch) {
+            // A failed computation throws past this point and leaves the previous value invalid.
+            value.reset();
+            value.emplace(compute());
+            expires = now + ttl;
+            computed_epoch = epoch;
+        }
+        return *value;
+    }
+
+private:
+    const Clock::duration ttl;
+    const uint32_t topic_mask;
+
+    std::mutex mutex;
+    std::optional<T> value;
+    Clock::time_point expires{};
+    uint64_t computed_epoch = 0;
+};
@@ -0,0 +1,132 @@
+#pragma once
+#include <concepts>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// ----=== Binary wire format ===----
+/// \brief Appends little-endian primitives to a byte string.
+class BinaryWriter {
+public:
+    explicit BinaryWriter(std::string &out) : out(out) {
+    }
+
+    void PutU8(const uint8_t value) {
+        out.push_back(static_cast<char>(value));
+    }
+
+    template<std::unsigned_integral T>
+    void PutInteger(const T value) {
+        for (size_t byte = 0; byte < sizeof(T); ++byte) {
+            out.push_back(static_cast<char>(value >> byte * 8 & 0xFF));
+        }
+    }
+
+    /// \brief 32-bit length followed by the bytes.
+    void PutString(const std::string_view value) {
+        PutInteger(static_cast<uint32_t>(value.size()));
+        out.append(value);
+    }
+
+    std::string &Buffer() { return out; }
+
+private:
+    std::string &out;
+};
+
+/// \brief Reads what BinaryWriter wrote. Throws std::out_of_range on truncated input.
+/// \details Strings are returned as views into the input, so nothing is copied until a field is assigned.
+class BinaryReader {
+public:
+    explicit BinaryReader(const std::string_view bytes) : bytes(bytes) {
+    }
+
+    uint8_t GetU8() {
+        Require(1);
+        return static_cast<uint8_t>(bytes[position++]);
+    }
+
+    template<std::unsigned_integral T>
+    T GetInteger() {
+        Require(sizeof(T));
+        T value = 0;
+        for (size_t byte = 0; byte < sizeof(T); ++byte) {
+            value |= static_cast<T>(static_cast<uint8_t>(bytes[position++])) << byte * 8;
+        }
+        return value;
+    }
+
+    std::string_view GetString() {
+        const auto size = GetInteger<uint32_t>();
+        Require(size);
+        const std::string_view value = bytes.substr(position, size);
+        position += size;
+        return value;
+    }
+
+    /// \brief Everything not read yet.
+    std::string_view Rest() const { return bytes.substr(position); }
+
+    bool AtEnd() const { return position == bytes.size(); }
+
+private:
+    void Require(const size_t size) const {
+        if (bytes.size() - position < size) {
+            throw std::out_of_range("Truncated binary message");
+        }
+    }
+
+    std::string_view bytes;
+    size_t position = 0;
+};
+
+/// \brief What follows the envelope of a binary message.
+enum class BinaryBody : uint8_t {
+    /// \brief Nothing; e.g. an action that failed or has no result.
+    Empty = 0,
+
+    /// \brief Fields of the action's DataStruct in descriptor order (see FieldDescriptors.h).
+    /// The type follows from the action, so only the sender and receiver of that action know the layout.
+    Fields = 1,
+
+    /// \brief Any other members of the message as a MessagePack map.
+    MsgPack = 2
+};
+
+/// \brief Opcode value meaning the action is named by its string instead, for peers without an opcode table.
+inline constexpr uint16_t NAMED_OPCODE = 0xFFFF;
+
+/// \brief Routing header of every binary message: transaction id, action and body kind.
+/// \details The action is a 16-bit opcode agreed at the handshake; only NAMED_OPCODE is followed by the name.
+struct BinaryEnvelope {
+    uint64_t transaction_id = 0;
+    uint16_t opcode = NAMED_OPCODE;
+    std::string_view name;
+    BinaryBody body = BinaryBody::Empty;
+};
+
+inline void WriteEnvelope(BinaryWriter &writer, const uint64_t transaction_id, const uint16_t opcode,
+                          const std::string_view name, const BinaryBody body) {
+    writer.PutInteger(transaction_id);
+    writer.PutInteger(opcode);
+    if (opcode == NAMED_OPCODE) {
+        writer.PutString(name);
+    }
+    writer.PutU8(static_cast<uint8_t>(body));
+}
+
+inline BinaryEnvelope ReadEnvelope(BinaryReader &reader) {
+    BinaryEnvelope envelope;
+    envelope.transaction_id = reader.GetInteger<uint64_t>();
+    envelope.opcode = reader.GetInteger<uint16_t>();
+    if (envelope.opcode == NAMED_OPCODE) {
+        envelope.name = reader.GetString();
+    }
+    const uint8_t body = reader.GetU8();
+    if (body > static_cast<uint8_t>(BinaryBody::MsgPack)) {
+        throw std::invalid_argument("Unknown binary body kind");
+    }
+    envelope.body = static_cast<BinaryBody>(body);
+    return envelope;
+}
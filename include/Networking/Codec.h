@@ -0,0 +1,142 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <json/json.hpp>
+#include <Networking/BinaryCodec.h>
+
+// ----=== Wire codecs ===----
+/// \brief Encoding of frame payloads on one connection.
+/// \details The handshake itself is always JSON. The client lists the codecs it can speak in preference order
+/// ("codecs" in its id message) and the server answers with the one it picked ("codec" in its Ok reply).
+/// Peers that do not take part in the negotiation stay on JSON, which also remains the debug format.
+enum class Codec : uint8_t {
+    Json = 0,
+    MsgPack = 1,
+    Cbor = 2,
+
+    /// \brief BinaryEnvelope followed by the action's DataStruct fields (see FieldDescriptors.h), or by a
+    /// MessagePack map for anything without descriptors, such as request data built by the admin.
+    Binary = 3
+};
+
+inline constexpr size_t CODEC_COUNT = 4;
+
+inline const char *CodecName(const Codec codec) {
+    switch (codec) {
+        case Codec::MsgPack: return "msgpack";
+        case Codec::Cbor: return "cbor";
+        case Codec::Binary: return "binary";
+        default: return "json";
+    }
+}
+
+inline std::optional<Codec> ParseCodec(const std::string_view name) {
+    if (name == "json") return Codec::Json;
+    if (name == "msgpack") return Codec::MsgPack;
+    if (name == "cbor") return Codec::Cbor;
+    if (name == "binary") return Codec::Binary;
+    return std::nullopt;
+}
+
+/// \brief Codecs a peer offers by default, best first.
+inline std::vector<Codec> DefaultCodecPreference() {
+    return {Codec::Binary, Codec::MsgPack, Codec::Cbor, Codec::Json};
+}
+
+/// \brief Picks the first codec in the peer's "codecs" list that this side understands. Falls back to JSON.
+inline Codec NegotiateCodec(const nlohmann::json &handshake) {
+    const auto offered = handshake.find("codecs");
+    if (offered == handshake.end() || !offered->is_array()) {
+        return Codec::Json;
+    }
+    for (const auto &name: *offered) {
+        if (name.is_string()) {
+            if (const auto codec = ParseCodec(name.get<std::string>())) {
+                return *codec;
+            }
+        }
+    }
+    return Codec::Json;
+}
+
+/// \brief Binary form of a generic message: the envelope from "transaction_id" and "index" (an opcode or a
+/// name), every other member as a MessagePack map. Throws nlohmann::json::exception if the routing members
+/// are missing.
+inline void EncodeBinaryMessage(const nlohmann::json &message, std::string &encoded) {
+    BinaryWriter writer(encoded);
+    nlohmann::json rest = nlohmann::json::object();
+    for (const auto &[key, value]: message.items()) {
+        if (key != "transaction_id" && key != "index") {
+            rest[key] = value;
+        }
+    }
+    const auto &index = message.at("index");
+    WriteEnvelope(writer, message.at("transaction_id").get<uint64_t>(),
+                  index.is_number_unsigned() ? index.get<uint16_t>() : NAMED_OPCODE,
+                  index.is_string() ? index.get_ref<const std::string &>() : std::string_view{},
+                  rest.empty() ? BinaryBody::Empty : BinaryBody::MsgPack);
+    if (!rest.empty()) {
+        nlohmann::json::to_msgpack(rest, encoded);
+    }
+}
+
+inline std::string EncodeMessage(const nlohmann::json &message, const Codec codec) {
+    std::string encoded;
+    switch (codec) {
+        case Codec::Binary:
+            EncodeBinaryMessage(message, encoded);
+            break;
+        case Codec::MsgPack:
+            nlohmann::json::to_msgpack(message, encoded);
+            break;
+        case Codec::Cbor:
+            nlohmann::json::to_cbor(message, encoded);
+            break;
+        default:
+            encoded = message.dump();
+            break;
+    }
+    return encoded;
+}
+
+/// \brief Turns the Fields body of a binary message into json members of `out`, using the descriptors of the
+/// envelope's action. Returns false if the action is unknown on this side.
+using FieldsDecoder = std::function<bool(const BinaryEnvelope &envelope, BinaryReader &reader,
+                                         nlohmann::json &out)>;
+
+/// \brief Throws nlohmann::json::parse_error if `payload` is not valid in `codec`, and std::exception for a
+/// malformed binary message or a Fields body that `decode_fields` cannot read.
+inline nlohmann::json DecodeMessage(const std::string_view payload, const Codec codec,
+                                    const FieldsDecoder &decode_fields = {}) {
+    switch (codec) {
+        case Codec::Binary: {
+            BinaryReader reader(payload);
+            const BinaryEnvelope envelope = ReadEnvelope(reader);
+            nlohmann::json message = nlohmann::json::object();
+            if (envelope.body == BinaryBody::MsgPack) {
+                message = nlohmann::json::from_msgpack(reader.Rest());
+            } else if (envelope.body == BinaryBody::Fields &&
+                       (!decode_fields || !decode_fields(envelope, reader, message))) {
+                throw std::invalid_argument("No field descriptors for this action");
+            }
+            message["transaction_id"] = envelope.transaction_id;
+            if (envelope.opcode == NAMED_OPCODE) {
+                message["index"] = envelope.name;
+            } else {
+                message["index"] = envelope.opcode;
+            }
+            return message;
+        }
+        case Codec::MsgPack:
+            return nlohmann::json::from_msgpack(payload);
+        case Codec::Cbor:
+            return nlohmann::json::from_cbor(payload);
+        default:
+            return nlohmann::json::parse(payload);
+    }
+}
@@ -0,0 +1,536 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <json/json.hpp>
+#include <Networking/BinaryCodec.h>
+#include <Networking/Codec.h>
+
+// ----=== Envelope peeking ===----
+/// \brief Routing fields of a message and where its payload lies, read without building a json object.
+/// \details All views point into the frame and are only valid as long as it is. The "index" member is either
+/// an opcode agreed at the handshake or the action's name; a name must be a plain string (no escape
+/// sequences), which holds for every action name.
+struct MessageEnvelope {
+    uint64_t transaction_id = 0;
+
+    /// \brief NAMED_OPCODE if the action is given by `index` instead.
+    uint16_t opcode = NAMED_OPCODE;
+    std::string_view index;
+
+    /// \brief The whole message, in `codec`.
+    std::string_view frame;
+    Codec codec = Codec::Json;
+
+    /// \brief Encoded value of the "data" member if the message has one; for a binary Fields body, the fields.
+    std::optional<std::string_view> data;
+    BinaryBody body = BinaryBody::Empty;
+
+    /// \brief Decodes only the "data" member. Throws if there is none or it is malformed.
+    nlohmann::json DecodeData() const {
+        if (!data) {
+            throw std::out_of_range("Message has no data");
+        }
+        if (body == BinaryBody::Fields) {
+            throw std::invalid_argument("Binary fields need the action's descriptors");
+        }
+        // A binary message keeps its generic members in MessagePack.
+        return DecodeMessage(*data, codec == Codec::Binary ? Codec::MsgPack : codec);
+    }
+};
+
+namespace envelope_detail {
+    constexpr unsigned MAX_DEPTH = 64;
+
+    // Walks one top-level map and hands every key with its value's byte range to `on_member`.
+    // The value scanners only check as much structure as they need to find the end of a value;
+    // the payload is validated when it is decoded.
+
+    // ----------------============JSON============---------------- //
+    class JsonScanner {
+    public:
+        explicit JsonScanner(const std::string_view text) : text(text) {
+        }
+
+        template<typename OnMember>
+        bool ScanObject(OnMember &&on_member) {
+            SkipSpace();
+            if (!Consume('{')) {
+                return false;
+            }
+            SkipSpace();
+            if (Consume('}')) {
+                return true;
+            }
+            while (true) {
+                SkipSpace();
+                std::string_view key;
+                if (!ScanString(key)) {
+                    return false;
+                }
+                SkipSpace();
+                if (!Consume(':')) {
+                    return false;
+                }
+                SkipSpace();
+                const size_t start = position;
+                if (!SkipValue(0)) {
+                    return false;
+                }
+                if (!on_member(key, text.substr(start, position - start))) {
+                    return false;
+                }
+                SkipSpace();
+                if (Consume('}')) {
+                    return true;
+                }
+                if (!Consume(',')) {
+                    return false;
+                }
+            }
+        }
+
+        /// \brief Raw contents of a string token; false if it is not a string or contains escapes.
+        static bool PlainString(const std::string_view token, std::string_view &out) {
+            if (token.size() < 2 || token.front() != '"' || token.back() != '"') {
+                return false;
+            }
+            out = token.substr(1, token.size() - 2);
+            return out.find('\\') == std::string_view::npos;
+        }
+
+    private:
+        void SkipSpace() {
+            while (position < text.size() && (text[position] == ' ' || text[position] == '\n' ||
+                                              text[position] == '\r' || text[position] == '\t')) {
+                ++position;
+            }
+        }
+
+        bool Consume(const char expected) {
+            if (position < text.size() && text[position] == expected) {
+                ++position;
+                return true;
+            }
+            return false;
+        }
+
+        bool SkipString() {
+            if (!Consume('"')) {
+                return false;
+            }
+            while (true) {
+                position = text.find_first_of("\"\\", position);
+                if (position == std::string_view::npos) {
+                    return false;
+                }
+                if (text[position] == '"') {
+                    ++position;
+                    return true;
+                }
+                position += 2;
+            }
+        }
+
+        bool ScanString(std::string_view &key) {
+            const size_t start = position;
+            if (!SkipString()) {
+                return false;
+            }
+            key = text.substr(start + 1, position - start - 2);
+            return true;
+        }
+
+        bool SkipValue(const unsigned depth) {
+            if (position >= text.size() || depth > MAX_DEPTH) {
+                return false;
+            }
+            const char first = text[position];
+            if (first == '"') {
+                return SkipString();
+            }
+            if (first == '{' || first == '[') {
+                const char close = first == '{' ? '}' : ']';
+                ++position;
+                SkipSpace();
+                if (Consume(close)) {
+                    return true;
+                }
+                while (true) {
+                    SkipSpace();
+                    if (first == '{') {
+                        if (!SkipString()) {
+                            return false;
+                        }
+                        SkipSpace();
+                        if (!Consume(':')) {
+                            return false;
+                        }
+                        SkipSpace();
+                    }
+                    if (!SkipValue(depth + 1)) {
+                        return false;
+                    }
+                    SkipSpace();
+                    if (Consume(close)) {
+                        return true;
+                    }
+                    if (!Consume(',')) {
+                        return false;
+                    }
+                }
+            }
+            // Number or literal: runs until the next delimiter.
+            const size_t start = position;
+            position = text.find_first_of(",}] \t\r\n", position);
+            if (position == std::string_view::npos) {
+                position = text.size();
+            }
+            return position > start;
+        }
+
+        std::string_view text;
+        size_t position = 0;
+    };
+
+    // ----------------============MessagePack / CBOR============---------------- //
+    /// \brief Big-endian reads over a byte range for the binary interchange formats.
+    class ByteScanner {
+    public:
+        explicit ByteScanner(const std::string_view bytes) : bytes(bytes) {
+        }
+
+        bool Byte(uint8_t &out) {
+            if (position >= bytes.size()) {
+                return false;
+            }
+            out = static_cast<uint8_t>(bytes[position++]);
+            return true;
+        }
+
+        bool BigEndian(const size_t size, uint64_t &out) {
+            if (bytes.size() - position < size) {
+                return false;
+            }
+            out = 0;
+            for (size_t byte = 0; byte < size; ++byte) {
+                out = out << 8 | static_cast<uint8_t>(bytes[position++]);
+            }
+            return true;
+        }
+
+        bool Skip(const uint64_t size) {
+            if (bytes.size() - position < size) {
+                return false;
+            }
+            position += size;
+            return true;
+        }
+
+        size_t Position() const { return position; }
+
+        std::string_view Slice(const size_t start) const { return bytes.substr(start, position - start); }
+
+    private:
+        std::string_view bytes;
+        size_t position = 0;
+    };
+
+    /// \brief Skips one MessagePack value. Nested items are counted rather than recursed into.
+    inline bool SkipMsgPack(ByteScanner &scanner) {
+        uint64_t pending = 1;
+        while (pending > 0) {
+            --pending;
+            uint8_t type = 0;
+            uint64_t size = 0;
+            if (!scanner.Byte(type)) {
+                return false;
+            }
+            if (type <= 0x7F || type >= 0xE0 || type == 0xC0 || type == 0xC2 || type == 0xC3) {
+                continue;
+            }
+            if (type <= 0x8F) {
+                pending += uint64_t{type & 0x0Fu} * 2;
+            } else if (type <= 0x9F) {
+                pending += type & 0x0Fu;
+            } else if (type <= 0xBF) {
+                if (!scanner.Skip(type & 0x1Fu)) return false;
+            } else {
+                switch (type) {
+                    case 0xC4: case 0xD9: if (!scanner.BigEndian(1, size) || !scanner.Skip(size)) return false; break;
+                    case 0xC5: case 0xDA: if (!scanner.BigEndian(2, size) || !scanner.Skip(size)) return false; break;
+                    case 0xC6: case 0xDB: if (!scanner.BigEndian(4, size) || !scanner.Skip(size)) return false; break;
+                    case 0xC7: if (!scanner.BigEndian(1, size) || !scanner.Skip(size + 1)) return false; break;
+                    case 0xC8: if (!scanner.BigEndian(2, size) || !scanner.Skip(size + 1)) return false; break;
+                    case 0xC9: if (!scanner.BigEndian(4, size) || !scanner.Skip(size + 1)) return false; break;
+                    case 0xCA: case 0xCE: case 0xD2: if (!scanner.Skip(4)) return false; break;
+                    case 0xCB: case 0xCF: case 0xD3: if (!scanner.Skip(8)) return false; break;
+                    case 0xCC: case 0xD0: if (!scanner.Skip(1)) return false; break;
+                    case 0xCD: case 0xD1: if (!scanner.Skip(2)) return false; break;
+                    case 0xD4: if (!scanner.Skip(2)) return false; break;
+                    case 0xD5: if (!scanner.Skip(3)) return false; break;
+                    case 0xD6: if (!scanner.Skip(5)) return false; break;
+                    case 0xD7: if (!scanner.Skip(9)) return false; break;
+                    case 0xD8: if (!scanner.Skip(17)) return false; break;
+                    case 0xDC: if (!scanner.BigEndian(2, size)) return false; pending += size; break;
+                    case 0xDD: if (!scanner.BigEndian(4, size)) return false; pending += size; break;
+                    case 0xDE: if (!scanner.BigEndian(2, size)) return false; pending += size * 2; break;
+                    case 0xDF: if (!scanner.BigEndian(4, size)) return false; pending += size * 2; break;
+                    default: return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    inline bool MsgPackMapSize(ByteScanner &scanner, uint64_t &size) {
+        uint8_t type = 0;
+        if (!scanner.Byte(type)) return false;
+        if (type >= 0x80 && type <= 0x8F) {
+            size = type & 0x0Fu;
+            return true;
+        }
+        if (type == 0xDE) return scanner.BigEndian(2, size);
+        if (type == 0xDF) return scanner.BigEndian(4, size);
+        return false;
+    }
+
+    inline bool MsgPackString(const std::string_view value, std::string_view &out) {
+        ByteScanner scanner(value);
+        uint8_t type = 0;
+        uint64_t size = 0;
+        if (!scanner.Byte(type)) return false;
+        if (type >= 0xA0 && type <= 0xBF) size = type & 0x1Fu;
+        else if (type == 0xD9) { if (!scanner.BigEndian(1, size)) return false; }
+        else if (type == 0xDA) { if (!scanner.BigEndian(2, size)) return false; }
+        else if (type == 0xDB) { if (!scanner.BigEndian(4, size)) return false; }
+        else return false;
+        const size_t start = scanner.Position();
+        if (!scanner.Skip(size)) return false;
+        out = scanner.Slice(start);
+        return true;
+    }
+
+    inline bool MsgPackUnsigned(const std::string_view value, uint64_t &out) {
+        ByteScanner scanner(value);
+        uint8_t type = 0;
+        if (!scanner.Byte(type)) return false;
+        if (type <= 0x7F) {
+            out = type;
+            return true;
+        }
+        if (type >= 0xCC && type <= 0xCF) return scanner.BigEndian(size_t{1} << (type - 0xCC), out);
+        return false;
+    }
+
+    template<typename OnMember>
+    bool ScanMsgPackMap(const std::string_view bytes, OnMember &&on_member) {
+        ByteScanner scanner(bytes);
+        uint64_t members = 0;
+        if (!MsgPackMapSize(scanner, members)) {
+            return false;
+        }
+        for (uint64_t member = 0; member < members; ++member) {
+            size_t start = scanner.Position();
+            if (!SkipMsgPack(scanner)) return false;
+            std::string_view key;
+            if (!MsgPackString(scanner.Slice(start), key)) return false;
+            start = scanner.Position();
+            if (!SkipMsgPack(scanner)) return false;
+            if (!on_member(key, scanner.Slice(start))) return false;
+        }
+        return true;
+    }
+
+    /// \brief Head of a CBOR item: major type and argument. Indefinite lengths are not used by our peers
+    /// and are rejected.
+    inline bool CborHead(ByteScanner &scanner, uint8_t &major, uint64_t &argument) {
+        uint8_t head = 0;
+        if (!scanner.Byte(head)) return false;
+        major = head >> 5;
+        const uint8_t info = head & 0x1F;
+        if (info < 24) {
+            argument = info;
+            return true;
+        }
+        if (info > 27) return false;
+        return scanner.BigEndian(size_t{1} << (info - 24), argument);
+    }
+
+    inline bool SkipCbor(ByteScanner &scanner) {
+        uint64_t pending = 1;
+        while (pending > 0) {
+            --pending;
+            uint8_t major = 0;
+            uint64_t argument = 0;
+            if (!CborHead(scanner, major, argument)) return false;
+            switch (major) {
+                case 2: case 3: if (!scanner.Skip(argument)) return false; break;
+                case 4: pending += argument; break;
+                case 5: pending += argument * 2; break;
+                case 6: ++pending; break;
+                default: break;
+            }
+        }
+        return true;
+    }
+
+    template<typename OnMember>
+    bool ScanCborMap(const std::string_view bytes, OnMember &&on_member) {
+        ByteScanner scanner(bytes);
+        uint8_t major = 0;
+        uint64_t members = 0;
+        if (!CborHead(scanner, major, members) || major != 5) {
+            return false;
+        }
+        for (uint64_t member = 0; member < members; ++member) {
+            uint64_t size = 0;
+            if (!CborHead(scanner, major, size) || major != 3) return false;
+            const size_t start = scanner.Position();
+            if (!scanner.Skip(size)) return false;
+            const std::string_view key = scanner.Slice(start);
+            const size_t value_start = scanner.Position();
+            if (!SkipCbor(scanner)) return false;
+            if (!on_member(key, scanner.Slice(value_start))) return false;
+        }
+        return true;
+    }
+
+    inline bool CborString(const std::string_view value, std::string_view &out) {
+        ByteScanner scanner(value);
+        uint8_t major = 0;
+        uint64_t size = 0;
+        if (!CborHead(scanner, major, size) || major != 3) return false;
+        const size_t start = scanner.Position();
+        if (!scanner.Skip(size)) return false;
+        out = scanner.Slice(start);
+        return true;
+    }
+
+    inline bool CborUnsigned(const std::string_view value, uint64_t &out) {
+        ByteScanner scanner(value);
+        uint8_t major = 0;
+        return CborHead(scanner, major, out) && major == 0;
+    }
+}
+
+/// \brief Reads transaction_id, the action and the "data" range of a message in `codec` without decoding the rest.
+/// Returns std::nullopt if the frame is malformed or either routing field is missing.
+inline std::optional<MessageEnvelope> PeekEnvelope(const std::string_view frame, const Codec codec) {
+    using namespace envelope_detail;
+
+    MessageEnvelope envelope;
+    envelope.frame = frame;
+    envelope.codec = codec;
+    bool has_transaction_id = false;
+    bool has_index = false;
+
+    // Keys and values are raw encoded bytes; `read_unsigned` and `read_string` know the encoding.
+    auto collect = [&](auto read_unsigned, auto read_string) {
+        return [&, read_unsigned, read_string](const std::string_view key, const std::string_view value) {
+            if (key == "transaction_id") {
+                has_transaction_id = read_unsigned(value, envelope.transaction_id);
+                return has_transaction_id;
+            }
+            if (key == "index") {
+                uint64_t opcode = 0;
+                if (read_unsigned(value, opcode)) {
+                    envelope.opcode = static_cast<uint16_t>(opcode);
+                    has_index = opcode < NAMED_OPCODE;
+                } else {
+                    has_index = read_string(value, envelope.index);
+                }
+                return has_index;
+            }
+            if (key == "data") {
+                envelope.data = value;
+            }
+            return true;
+        };
+    };
+
+    switch (codec) {
+        case Codec::Binary: {
+            try {
+                BinaryReader reader(frame);
+                const BinaryEnvelope binary = ReadEnvelope(reader);
+                envelope.transaction_id = binary.transaction_id;
+                envelope.opcode = binary.opcode;
+                envelope.index = binary.name;
+                envelope.body = binary.body;
+                if (binary.body == BinaryBody::Fields) {
+                    envelope.data = reader.Rest();
+                } else if (binary.body == BinaryBody::MsgPack) {
+                    // Routing fields are in the header; only "data" is looked for in the map.
+                    const bool is_map = ScanMsgPackMap(reader.Rest(), [&](const std::string_view key,
+                                                                          const std::string_view value) {
+                        if (key == "data") {
+                            envelope.data = value;
+                        }
+                        return true;
+                    });
+                    if (!is_map) {
+                        return std::nullopt;
+                    }
+                }
+                return envelope;
+            } catch (const std::exception &) {
+                return std::nullopt;
+            }
+        }
+        case Codec::MsgPack:
+            if (!ScanMsgPackMap(frame, collect(MsgPackUnsigned, MsgPackString))) {
+                return std::nullopt;
+            }
+            break;
+        case Codec::Cbor:
+            if (!ScanCborMap(frame, collect(CborUnsigned, CborString))) {
+                return std::nullopt;
+            }
+            break;
+        default: {
+            const auto json_unsigned = [](const std::string_view token, uint64_t &out) {
+                const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), out);
+                return error == std::errc{} && end == token.data() + token.size();
+            };
+            if (!JsonScanner(frame).ScanObject(collect(json_unsigned, JsonScanner::PlainString))) {
+                return std::nullopt;
+            }
+            break;
+        }
+    }
+
+    if (!has_transaction_id || !has_index) {
+        return std::nullopt;
+    }
+    return envelope;
+}
+
+// ----=== Matched responses ===----
+/// \brief A response that was routed to its request. Owns a copy of the frame and decodes it only when asked,
+/// so callers that just need to know a response arrived never build a json object.
+class Response {
+public:
+    explicit Response(const MessageEnvelope &envelope) : bytes(envelope.frame), codec(envelope.codec) {
+    }
+
+    /// \brief The whole response as json; std::nullopt if the payload turns out to be malformed.
+    std::optional<nlohmann::json> Json(const FieldsDecoder &decode_fields = {}) const {
+        try {
+            return DecodeMessage(bytes, codec, decode_fields);
+        } catch (const std::exception &) {
+            return std::nullopt;
+        }
+    }
+
+    std::string_view Bytes() const { return bytes; }
+
+    Codec GetCodec() const { return codec; }
+
+private:
+    std::string bytes;
+    Codec codec;
+};
@@ -0,0 +1,363 @@
+#include "EpollEventLoop.h"
+
+#include <ranges>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#elif defined(_WIN32)
+#define poll WSAPoll
+#else
+#include <poll.h>
+#endif
+
+namespace {
+    constexpr int POLL_TIMEOUT_MS = 100;
+    constexpr int MAX_EVENTS = 256;
+}
+
+EpollEventLoop::EpollEventLoop(const size_t worker_count) {
+    for (size_t i = 0; i < std::max<size_t>(worker_count, 1); ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+}
+
+EpollEventLoop::~EpollEventLoop() {
+    Stop();
+}
+
+void EpollEventLoop::Start(Handlers handlers) {
+    on_frame = std::move(handlers.on_frame);
+    on_close = std::move(handlers.on_close);
+    on_accept = std::move(handlers.on_accept);
+    on_tick = std::move(handlers.on_tick);
+    is_running = true;
+
+    for (const auto &worker: workers) {
+#if defined(__linux__)
+        worker->poll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (worker->poll_fd == -1) {
+            throw std::runtime_error("epoll_create1 failed.");
+        }
+#endif
+        worker->thread = std::thread(&EpollEventLoop::RunWorker, this, std::ref(*worker));
+    }
+}
+
+void EpollEventLoop::Stop() {
+    if (!is_running.exchange(false)) {
+        return;
+    }
+
+    for (const auto &worker: workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+
+        std::vector<std::shared_ptr<Connection> > open_connections;
+        {
+            std::lock_guard lock(worker->connections_mutex);
+            for (const auto &connection: worker->connections | std::views::values) {
+                open_connections.push_back(connection);
+            }
+            worker->connections.clear();
+        }
+#if defined(__linux__)
+        close(worker->poll_fd);
+#endif
+
+        // Same as Release, so owners see every connection close whichever backend runs.
+        for (const auto &connection: open_connections) {
+            {
+                std::lock_guard send_lock(connection->send_mutex);
+                connection->is_open = false;
+                connection->send_queue.clear();
+            }
+            closesocket(connection->socket);
+            if (on_close) {
+                on_close(connection);
+            }
+        }
+    }
+}
+
+void EpollEventLoop::Listen(const SOCKET listener) {
+    if (!SetNonBlocking(listener)) {
+        throw std::runtime_error("Failed to switch listening socket to non-blocking mode.");
+    }
+    listen_socket = listener;
+
+#if defined(__linux__)
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLET;
+    event.data.fd = listener;
+    if (epoll_ctl(workers.front()->poll_fd, EPOLL_CTL_ADD, listener, &event) == -1) {
+        throw std::runtime_error("epoll_ctl failed for the listening socket.");
+    }
+#endif
+}
+
+std::shared_ptr<Connection> EpollEventLoop::Add(const SOCKET socket, const size_t id, FrameBuffer &&buffer) {
+    if (!SetNonBlocking(socket)) {
+        throw std::runtime_error("Failed to switch socket to non-blocking mode.");
+    }
+
+    auto connection = std::make_shared<Connection>(socket, id, std::move(buffer));
+
+    // Frames that arrived before the socket was handed over are already sitting in the buffer.
+    DispatchFrames(connection);
+
+    Register(connection);
+    return connection;
+}
+
+void EpollEventLoop::Register(const std::shared_ptr<Connection> &connection) {
+    connection->worker_index = next_worker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+    Worker &worker = *workers[connection->worker_index];
+
+    {
+        std::lock_guard lock(worker.connections_mutex);
+        worker.connections[connection->socket] = connection;
+    }
+
+#if defined(__linux__)
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.fd = connection->socket;
+    if (epoll_ctl(worker.poll_fd, EPOLL_CTL_ADD, connection->socket, &event) == -1) {
+        std::lock_guard lock(worker.connections_mutex);
+        worker.connections.erase(connection->socket);
+        throw std::runtime_error("epoll_ctl failed.");
+    }
+#endif
+}
+
+void EpollEventLoop::AcceptConnections() {
+    while (is_running) {
+#if defined(__linux__)
+        const SOCKET socket = accept4(listen_socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+        const SOCKET socket = accept(listen_socket, nullptr, nullptr);
+#endif
+        if (socket == INVALID_SOCKET) {
+            if (Interrupted()) continue;
+            accept_stalled = !WouldBlock();
+            if (accept_stalled) {
+                std::cout << "Error... Accept failed on the listening socket.\n";
+            }
+            return;
+        }
+
+#if !defined(__linux__)
+        if (!SetNonBlocking(socket)) {
+            closesocket(socket);
+            continue;
+        }
+#endif
+        const auto connection = std::make_shared<Connection>(socket, 0, FrameBuffer{});
+        // The accept handler has to see the connection before a worker can deliver its first frame.
+        if (on_accept) {
+            on_accept(connection);
+        }
+        try {
+            Register(connection);
+        } catch (const std::exception &e) {
+            std::cout << "Error... " << e.what() << "\n";
+            connection->is_open = false;
+            closesocket(socket);
+            if (on_close) {
+                on_close(connection);
+            }
+        }
+    }
+}
+
+DataStatus EpollEventLoop::Send(const std::shared_ptr<Connection> &connection, SharedPayload payload) {
+    if (payload->size() > MAX_FRAME_SIZE) {
+        return DataStatus::DataNotSent;
+    }
+    std::lock_guard lock(connection->send_mutex);
+    if (!connection->IsOpen()) {
+        return DataStatus::DataNotSent;
+    }
+
+    const bool was_idle = connection->send_queue.empty();
+    connection->send_queue.emplace_back(std::move(payload));
+
+    // If frames are already queued, the worker flushes them once the socket becomes writable.
+    if (was_idle && !FlushSendQueue(*connection)) {
+        ShutdownLocked(*connection);
+        return DataStatus::DataNotSent;
+    }
+    return DataStatus::DataSent;
+}
+
+// -----------------============WORKERS============----------------- //
+void EpollEventLoop::RunWorker(Worker &worker) {
+    const bool is_first_worker = &worker == workers.front().get();
+    auto last_tick = std::chrono::steady_clock::now();
+
+#if defined(__linux__)
+    epoll_event events[MAX_EVENTS];
+
+    while (is_running) {
+        const int ready = epoll_wait(worker.poll_fd, events, MAX_EVENTS, POLL_TIMEOUT_MS);
+        if (is_first_worker) {
+            MaybeTick(last_tick);
+            if (accept_stalled) {
+                AcceptConnections();
+            }
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            if (is_first_worker && events[i].data.fd == listen_socket) {
+                AcceptConnections();
+                continue;
+            }
+
+            std::shared_ptr<Connection> connection;
+            {
+                std::lock_guard lock(worker.connections_mutex);
+                const auto it = worker.connections.find(events[i].data.fd);
+                if (it == worker.connections.end()) continue;
+                connection = it->second;
+            }
+
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                ReadFromConnection(worker, connection);
+            }
+            if (connection->IsOpen() && events[i].events & EPOLLOUT) {
+                std::unique_lock lock(connection->send_mutex);
+                if (!FlushSendQueue(*connection)) {
+                    lock.unlock();
+                    Release(worker, connection);
+                }
+            }
+        }
+    }
+#else
+    // Portable fallback: level-triggered poll() over the worker's connections.
+    std::vector<pollfd> poll_fds;
+    std::vector<std::shared_ptr<Connection> > polled;
+
+    while (is_running) {
+        if (is_first_worker) {
+            MaybeTick(last_tick);
+        }
+
+        poll_fds.clear();
+        polled.clear();
+        {
+            std::lock_guard lock(worker.connections_mutex);
+            for (const auto &connection: worker.connections | std::views::values) {
+                poll_fds.push_back(pollfd{connection->socket, POLLIN, 0});
+                polled.push_back(connection);
+            }
+        }
+        // The listening socket, if any, goes last so `polled` stays aligned with the front of `poll_fds`.
+        const bool is_listening = is_first_worker && listen_socket != INVALID_SOCKET;
+        if (is_listening) {
+            poll_fds.push_back(pollfd{listen_socket, POLLIN, 0});
+        }
+        if (poll_fds.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_TIMEOUT_MS));
+            continue;
+        }
+
+        poll(poll_fds.data(), static_cast<unsigned long>(poll_fds.size()), POLL_TIMEOUT_MS);
+        if (is_listening && poll_fds.back().revents & POLLIN) {
+            AcceptConnections();
+        }
+        for (size_t i = 0; i < polled.size(); ++i) {
+            if (poll_fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                ReadFromConnection(worker, polled[i]);
+            }
+            if (polled[i]->IsOpen()) {
+                std::unique_lock lock(polled[i]->send_mutex);
+                if (!FlushSendQueue(*polled[i])) {
+                    lock.unlock();
+                    Release(worker, polled[i]);
+                }
+            }
+        }
+    }
+#endif
+}
+
+void EpollEventLoop::ReadFromConnection(Worker &worker, const std::shared_ptr<Connection> &connection) {
+    FrameBuffer &buffer = connection->recv_buffer;
+
+    // Edge-triggered: keep reading until the socket is drained.
+    while (connection->IsOpen()) {
+        const std::span<char> space = buffer.PrepareWrite();
+        const int bytes_received = recv(connection->socket, space.data(),
+                                        static_cast<int>(std::min<size_t>(space.size(), INT32_MAX)), 0);
+        if (bytes_received > 0) {
+            buffer.CommitWrite(static_cast<size_t>(bytes_received));
+            if (!DispatchFrames(connection)) {
+                Release(worker, connection);
+                return;
+            }
+            continue;
+        }
+        if (bytes_received == SOCKET_ERROR && Interrupted()) {
+            continue;
+        }
+        if (bytes_received == SOCKET_ERROR && WouldBlock()) {
+            return;
+        }
+
+        // Orderly shutdown by the peer or a hard socket error.
+        Release(worker, connection);
+        return;
+    }
+}
+
+void EpollEventLoop::Release(Worker &worker, const std::shared_ptr<Connection> &connection) {
+    {
+        // Once is_open is cleared under send_mutex no other thread touches the socket.
+        std::lock_guard lock(connection->send_mutex);
+        if (!connection->IsOpen()) return;
+
+        connection->is_open.store(false, std::memory_order_release);
+        connection->send_queue.clear();
+#if defined(__linux__)
+        epoll_ctl(worker.poll_fd, EPOLL_CTL_DEL, connection->socket, nullptr);
+#endif
+    }
+    {
+        std::lock_guard lock(worker.connections_mutex);
+        worker.connections.erase(connection->socket);
+    }
+    closesocket(connection->socket);
+
+    if (on_close) {
+        on_close(connection);
+    }
+}
+
+bool EpollEventLoop::FlushSendQueue(Connection &connection) {
+    while (!connection.send_queue.empty()) {
+#ifdef _WIN32
+        const OutgoingFrame &front = connection.send_queue.front();
+        const bool in_header = front.offset < FRAME_HEADER_SIZE;
+        const char *chunk = in_header
+                                ? front.header + front.offset
+                                : front.payload->data() + (front.offset - FRAME_HEADER_SIZE);
+        const size_t chunk_size = in_header ? FRAME_HEADER_SIZE - front.offset : front.Size() - front.offset;
+        const int sent = send(connection.socket, chunk, static_cast<int>(chunk_size), 0);
+#else
+        // Gather as many queued frames as fit into one sendmsg call.
+        iovec iov[MAX_IOV];
+        msghdr message{};
+        message.msg_iov = iov;
+        message.msg_iovlen = GatherSendQueue(connection, iov, MAX_IOV);
+        const ssize_t sent = sendmsg(connection.socket, &message, MSG_NOSIGNAL | MSG_DONTWAIT);
+#endif
+        if (sent == SOCKET_ERROR) {
+            if (Interrupted()) continue;
+            return WouldBlock();
+        }
+        ConsumeSendQueue(connection, static_cast<size_t>(sent));
+    }
+    return true;
+}
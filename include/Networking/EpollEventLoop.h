@@ -0,0 +1,70 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+
+#include <Networking/EventLoop.h>
+
+/// \brief Readiness-based backend: one edge-triggered epoll instance per worker.
+/// \details Sends are written on the caller's thread as far as the socket accepts them; the owning
+/// worker flushes the rest once EPOLLOUT fires. The listening socket, if any, lives on the first worker.
+/// Other platforms use a level-triggered poll() loop.
+class EpollEventLoop final : public EventLoop {
+public:
+    explicit EpollEventLoop(size_t worker_count = DefaultWorkerCount());
+
+    ~EpollEventLoop() override;
+
+    EpollEventLoop(const EpollEventLoop &) = delete;
+
+    EpollEventLoop &operator=(const EpollEventLoop &) = delete;
+
+    void Start(Handlers handlers) override;
+
+    void Stop() override;
+
+    void Listen(SOCKET listener) override;
+
+    std::shared_ptr<Connection> Add(SOCKET socket, size_t id, FrameBuffer &&buffer = FrameBuffer{}) override;
+
+    using EventLoop::Send;
+
+    DataStatus Send(const std::shared_ptr<Connection> &connection, SharedPayload payload) override;
+
+    size_t WorkerCount() const override { return workers.size(); }
+
+    const char *Name() const override { return "epoll"; }
+
+private:
+    struct Worker {
+        int poll_fd = -1;
+        std::thread thread;
+
+        std::mutex connections_mutex;
+        std::unordered_map<SOCKET, std::shared_ptr<Connection> > connections;
+    };
+
+    void RunWorker(Worker &worker);
+
+    /// \brief Registers the connection with the next worker in round-robin order.
+    void Register(const std::shared_ptr<Connection> &connection);
+
+    /// \brief Accepts until the listening socket would block. Runs on the first worker.
+    void AcceptConnections();
+
+    void ReadFromConnection(Worker &worker, const std::shared_ptr<Connection> &connection);
+
+    void Release(Worker &worker, const std::shared_ptr<Connection> &connection);
+
+    /// \brief Writes queued frames until the socket would block. Returns false if the connection broke.
+    /// The caller must hold the connection's send_mutex.
+    static bool FlushSendQueue(Connection &connection);
+
+    std::vector<std::unique_ptr<Worker> > workers;
+    std::atomic<SOCKET> listen_socket{INVALID_SOCKET};
+
+    /// \brief Set when accept failed with a real error (e.g. out of descriptors). Edge-triggered epoll
+    /// will not report the pending connections again, so the first worker retries on every pass.
+    bool accept_stalled = false;
+    std::atomic<size_t> next_worker{0};
+    std::atomic<bool> is_running{false};
+};
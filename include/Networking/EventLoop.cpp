@@ -0,0 +1,125 @@
+#include "EventLoop.h"
+
+#include "EpollEventLoop.h"
+#include "IoUringEventLoop.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+std::optional<EventLoopBackend> ParseEventLoopBackend(const std::string_view name) {
+    if (name == "epoll") return EventLoopBackend::Epoll;
+    if (name == "io_uring" || name == "uring") return EventLoopBackend::IoUring;
+    return std::nullopt;
+}
+
+std::unique_ptr<EventLoop> EventLoop::Create(const EventLoopBackend backend, const size_t worker_count) {
+    if (backend == EventLoopBackend::IoUring) {
+#if HAS_IO_URING
+        try {
+            return std::make_unique<IoUringEventLoop>(worker_count);
+        } catch (const std::exception &e) {
+            std::cerr << "io_uring backend unavailable (" << e.what() << "). Falling back to epoll.\n";
+        }
+#else
+        std::cerr << "io_uring backend is not compiled in. Falling back to epoll.\n";
+#endif
+    }
+    return std::make_unique<EpollEventLoop>(worker_count);
+}
+
+void EventLoop::Close(const std::shared_ptr<Connection> &connection) {
+    // The backends clear is_open under send_mutex before closing the socket, so holding it here keeps the
+    // handle from being closed, and its number reused by a new accept, between the check and the shutdown.
+    std::lock_guard lock(connection->send_mutex);
+    ShutdownLocked(*connection);
+}
+
+void EventLoop::ShutdownLocked(const Connection &connection) {
+    if (connection.IsOpen()) {
+#ifdef _WIN32
+        shutdown(connection.socket, SD_BOTH);
+#else
+        shutdown(connection.socket, SHUT_RDWR);
+#endif
+    }
+}
+
+// -----------------============HELPERS============----------------- //
+bool EventLoop::SetNonBlocking(const SOCKET socket) {
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+    const int flags = fcntl(socket, F_GETFL, 0);
+    return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) != -1;
+#endif
+}
+
+bool EventLoop::WouldBlock() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+bool EventLoop::Interrupted() {
+#ifdef _WIN32
+    return false;
+#else
+    return errno == EINTR;
+#endif
+}
+
+#ifndef _WIN32
+size_t EventLoop::GatherSendQueue(Connection &connection, iovec *iov, const size_t max_iov) {
+    size_t iov_count = 0;
+    for (OutgoingFrame &frame: connection.send_queue) {
+        if (iov_count + 2 > max_iov) break;
+        if (frame.offset < FRAME_HEADER_SIZE) {
+            iov[iov_count++] = {frame.header + frame.offset, FRAME_HEADER_SIZE - frame.offset};
+            iov[iov_count++] = {const_cast<char *>(frame.payload->data()), frame.payload->size()};
+        } else {
+            const size_t offset = frame.offset - FRAME_HEADER_SIZE;
+            iov[iov_count++] = {const_cast<char *>(frame.payload->data()) + offset, frame.payload->size() - offset};
+        }
+    }
+    return iov_count;
+}
+#endif
+
+void EventLoop::ConsumeSendQueue(Connection &connection, size_t bytes) {
+    auto &queue = connection.send_queue;
+    while (bytes > 0 && !queue.empty()) {
+        OutgoingFrame &front = queue.front();
+        const size_t left = front.Size() - front.offset;
+        if (bytes < left) {
+            front.offset += bytes;
+            return;
+        }
+        bytes -= left;
+        queue.pop_front();
+    }
+}
+
+bool EventLoop::DispatchFrames(const std::shared_ptr<Connection> &connection) const {
+    while (const auto frame = connection->recv_buffer.NextFrame()) {
+        on_frame(connection, *frame);
+    }
+    if (connection->recv_buffer.IsCorrupted()) {
+        std::cout << "Error... Oversized frame announced on socket: " << connection->socket << "\n";
+        return false;
+    }
+    return true;
+}
+
+void EventLoop::MaybeTick(std::chrono::steady_clock::time_point &last_tick) const {
+    if (!on_tick) return;
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_tick >= TICK_INTERVAL) {
+        last_tick = now;
+        on_tick();
+    }
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <Networking/Networking.h>
+
+// ----=== Event loop ===----
+/// \brief Frame waiting in a Connection's send queue.
+struct OutgoingFrame {
+    char header[FRAME_HEADER_SIZE]{};
+    SharedPayload payload;
+
+    /// \brief Bytes of header + payload already written to the socket.
+    size_t offset = 0;
+
+    explicit OutgoingFrame(SharedPayload data) : payload(std::move(data)) {
+        WriteFrameHeader(header, payload->size());
+    }
+
+    size_t Size() const { return FRAME_HEADER_SIZE + payload->size(); }
+};
+
+/// \brief Socket owned by an EventLoop, with its receive buffer and send queue.
+/// \details Everything below `id` belongs to the event loop backend and must not be touched by its users.
+class Connection {
+public:
+    Connection(const SOCKET socket, const size_t id, FrameBuffer &&buffer)
+        : socket(socket), id(id), recv_buffer(std::move(buffer)) {
+    }
+
+    bool IsOpen() const { return is_open.load(std::memory_order_acquire); }
+
+    /// \brief Socket handle. Only valid while IsOpen().
+    const SOCKET socket;
+
+    /// \brief Identifier given by the owner of the loop (the client id on the server).
+    std::atomic<size_t> id;
+
+    /// \brief Set by the owner once the peer has identified itself. Accepted connections start unidentified.
+    std::atomic<bool> is_identified{false};
+
+    FrameBuffer recv_buffer;
+
+    std::mutex send_mutex;
+    std::deque<OutgoingFrame> send_queue;
+
+    std::atomic<bool> is_open{true};
+
+    /// \brief Set while the connection waits in its worker's flush list.
+    std::atomic<bool> flush_scheduled{false};
+    size_t worker_index = 0;
+};
+
+enum class EventLoopBackend {
+    Epoll,
+    IoUring
+};
+
+std::optional<EventLoopBackend> ParseEventLoopBackend(std::string_view name);
+
+/// \brief Reactor that owns every client socket.
+/// \details A fixed number of workers wait for socket activity, reassemble frames in the connection's
+/// FrameBuffer and hand complete frames to the frame handler. Connections are spread round-robin over
+/// the workers, so the thread count does not depend on how many clients are connected.
+/// The backend (epoll or io_uring) is picked once at startup through Create().
+class EventLoop {
+public:
+    using FrameHandler = std::function<void(const std::shared_ptr<Connection> &, std::string_view)>;
+    using CloseHandler = std::function<void(const std::shared_ptr<Connection> &)>;
+    using AcceptHandler = std::function<void(const std::shared_ptr<Connection> &)>;
+    using TickHandler = std::function<void()>;
+
+    /// \brief Callbacks invoked on worker threads. None of them may block.
+    struct Handlers {
+        FrameHandler on_frame;
+        CloseHandler on_close;
+
+        /// \brief Runs for every accepted socket before its first frame can be delivered.
+        AcceptHandler on_accept;
+
+        /// \brief Runs on the first worker about every TICK_INTERVAL, e.g. to expire deadlines.
+        TickHandler on_tick;
+    };
+
+    static constexpr auto TICK_INTERVAL = std::chrono::milliseconds(100);
+
+    virtual ~EventLoop() = default;
+
+    virtual void Start(Handlers handlers) = 0;
+
+    virtual void Stop() = 0;
+
+    /// \brief Accepts connections on an already listening socket from inside the loop. Call after Start().
+    virtual void Listen(SOCKET listener) = 0;
+
+    /// \brief Hands an already connected socket to the loop. Bytes already received for it may be passed in `buffer`.
+    virtual std::shared_ptr<Connection> Add(SOCKET socket, size_t id, FrameBuffer &&buffer = FrameBuffer{}) = 0;
+
+    /// \brief Queues one frame on the connection. Returns DataNotSent if the connection is already closed or
+    /// the payload exceeds MAX_FRAME_SIZE.
+    /// The payload is only referenced, never copied, so the same buffer may be queued on any number of connections.
+    virtual DataStatus Send(const std::shared_ptr<Connection> &connection, SharedPayload payload) = 0;
+
+    DataStatus Send(const std::shared_ptr<Connection> &connection, std::string payload) {
+        return Send(connection, std::make_shared<const std::string>(std::move(payload)));
+    }
+
+    virtual size_t WorkerCount() const = 0;
+
+    virtual const char *Name() const = 0;
+
+    /// \brief Shuts the socket down. The close handler runs on the owning worker. Takes send_mutex.
+    static void Close(const std::shared_ptr<Connection> &connection);
+
+    static size_t DefaultWorkerCount() {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /// \brief Creates the requested backend. Falls back to epoll if io_uring is not available on this host.
+    static std::unique_ptr<EventLoop> Create(EventLoopBackend backend, size_t worker_count = DefaultWorkerCount());
+
+protected:
+    static constexpr size_t MAX_IOV = 64;
+
+    static bool SetNonBlocking(SOCKET socket);
+
+    static bool WouldBlock();
+
+    static bool Interrupted();
+
+#ifndef _WIN32
+    /// \brief Fills `iov` with the unsent parts of queued frames. The caller must hold send_mutex.
+    static size_t GatherSendQueue(Connection &connection, iovec *iov, size_t max_iov);
+#endif
+
+    /// \brief Close() for callers that already hold send_mutex.
+    static void ShutdownLocked(const Connection &connection);
+
+    /// \brief Drops `bytes` written bytes from the front of the send queue. The caller must hold send_mutex.
+    static void ConsumeSendQueue(Connection &connection, size_t bytes);
+
+    /// \brief Hands every complete frame in the receive buffer to the frame handler.
+    /// Returns false if the peer announced an oversized frame.
+    bool DispatchFrames(const std::shared_ptr<Connection> &connection) const;
+
+    /// \brief Calls on_tick if TICK_INTERVAL has passed since `last_tick`.
+    void MaybeTick(std::chrono::steady_clock::time_point &last_tick) const;
+
+    FrameHandler on_frame;
+    CloseHandler on_close;
+    AcceptHandler on_accept;
+    TickHandler on_tick;
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+
+// ----=== Wire framing ===----
+/// \brief Every message on the wire is a 4-byte big-endian payload length followed by the payload.
+inline constexpr size_t FRAME_HEADER_SIZE = 4;
+
+/// \brief Upper bound for a single frame. Anything above it is treated as a corrupted stream.
+inline constexpr size_t MAX_FRAME_SIZE = 256 * 1024 * 1024;
+
+/// \brief Writes the length prefix. `payload_size` must not exceed MAX_FRAME_SIZE; senders check it first.
+inline void WriteFrameHeader(char *out, const size_t payload_size) {
+    const auto size = static_cast<uint32_t>(payload_size);
+    out[0] = static_cast<char>(size >> 24 & 0xFF);
+    out[1] = static_cast<char>(size >> 16 & 0xFF);
+    out[2] = static_cast<char>(size >> 8 & 0xFF);
+    out[3] = static_cast<char>(size & 0xFF);
+}
+
+inline size_t ReadFrameHeader(const char *in) {
+    const auto *bytes = reinterpret_cast<const unsigned char *>(in);
+    return static_cast<size_t>(bytes[0]) << 24 | static_cast<size_t>(bytes[1]) << 16 |
+           static_cast<size_t>(bytes[2]) << 8 | static_cast<size_t>(bytes[3]);
+}
+
+/// \brief Per-connection receive buffer that reassembles length-prefixed frames.
+/// \details Bytes are appended at the tail by recv() and complete frames are handed out as views
+/// into the buffer, so a frame is never copied before it reaches json::parse. The buffer only grows
+/// when a frame does not fit; otherwise consumed space is reclaimed by sliding the unread tail to
+/// the front, so steady-state receiving does not allocate. Storage is allocated on first use, so
+/// connections whose frames never need reassembly cost nothing.
+class FrameBuffer {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+    static constexpr size_t MIN_READ_SIZE = 16 * 1024;
+
+    explicit FrameBuffer(const size_t initial_capacity = DEFAULT_CAPACITY)
+        : initial_capacity(std::max(initial_capacity, MIN_READ_SIZE)) {
+    }
+
+    FrameBuffer(FrameBuffer &&) noexcept = default;
+
+    FrameBuffer &operator=(FrameBuffer &&) noexcept = default;
+
+    /// \brief Returns writable space at the tail with room for at least the rest of the pending frame.
+    /// \details Views returned by NextFrame() are invalidated by this call.
+    std::span<char> PrepareWrite() {
+        ReleaseFrame();
+
+        size_t required = MIN_READ_SIZE;
+        if (Readable() >= FRAME_HEADER_SIZE && !IsCorrupted()) {
+            const size_t frame_size = FRAME_HEADER_SIZE + ReadFrameHeader(data.get() + read_pos);
+            if (frame_size > Readable()) {
+                required = std::max(required, frame_size - Readable());
+            }
+        }
+
+        Reserve(required);
+        return {data.get() + write_pos, capacity - write_pos};
+    }
+
+    /// \brief Copies bytes received elsewhere (e.g. into a registered io_uring buffer) to the tail.
+    void Append(const std::string_view bytes) {
+        ReleaseFrame();
+        if (bytes.empty()) return;
+        Reserve(bytes.size());
+        std::memcpy(data.get() + write_pos, bytes.data(), bytes.size());
+        write_pos += bytes.size();
+    }
+
+    /// \brief Marks `bytes` bytes of the span returned by PrepareWrite() as received.
+    void CommitWrite(const size_t bytes) {
+        write_pos += bytes;
+    }
+
+    /// \brief Returns the next complete frame payload, or std::nullopt if more bytes are needed.
+    /// \details The previously returned frame is released first. The view stays valid until the next
+    /// call to NextFrame() or PrepareWrite().
+    std::optional<std::string_view> NextFrame() {
+        ReleaseFrame();
+
+        if (Readable() < FRAME_HEADER_SIZE) {
+            return std::nullopt;
+        }
+        const size_t payload_size = ReadFrameHeader(data.get() + read_pos);
+        if (Readable() < FRAME_HEADER_SIZE + payload_size) {
+            return std::nullopt;
+        }
+
+        pending_release = FRAME_HEADER_SIZE + payload_size;
+        return std::string_view{data.get() + read_pos + FRAME_HEADER_SIZE, payload_size};
+    }
+
+    /// \brief True if the stream announced a frame larger than MAX_FRAME_SIZE.
+    bool IsCorrupted() const {
+        return Readable() >= FRAME_HEADER_SIZE && ReadFrameHeader(data.get() + read_pos) > MAX_FRAME_SIZE;
+    }
+
+    size_t Readable() const { return write_pos - read_pos; }
+
+    void Clear() {
+        read_pos = write_pos = pending_release = 0;
+    }
+
+private:
+    void ReleaseFrame() {
+        read_pos += pending_release;
+        pending_release = 0;
+        if (read_pos == write_pos) {
+            read_pos = write_pos = 0;
+        }
+    }
+
+    void Reserve(const size_t required) {
+        if (capacity - write_pos < required) {
+            Compact();
+        }
+        if (capacity - write_pos < required) {
+            Grow(write_pos + required);
+        }
+    }
+
+    void Compact() {
+        if (read_pos == 0) return;
+        std::memmove(data.get(), data.get() + read_pos, Readable());
+        write_pos -= read_pos;
+        read_pos = 0;
+    }
+
+    void Grow(const size_t min_capacity) {
+        size_t new_capacity = std::max(capacity, initial_capacity);
+        while (new_capacity < min_capacity) {
+            new_capacity *= 2;
+        }
+        auto new_data = std::make_unique_for_overwrite<char[]>(new_capacity);
+        if (data) {
+            std::memcpy(new_data.get(), data.get() + read_pos, Readable());
+        }
+        write_pos -= read_pos;
+        read_pos = 0;
+        data = std::move(new_data);
+        capacity = new_capacity;
+    }
+
+    std::unique_ptr<char[]> data;
+    size_t initial_capacity = DEFAULT_CAPACITY;
+    size_t capacity = 0;
+    size_t read_pos = 0;
+    size_t write_pos = 0;
+    size_t pending_release = 0;
+};
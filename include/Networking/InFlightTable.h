@@ -0,0 +1,163 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Networking/Envelope.h>
+
+// ----=== In-flight transactions ===----
+/// \brief Requests sent on one connection that are still waiting for a response, keyed by transaction_id.
+/// \details Any number of requests may be outstanding at once; responses are matched by transaction_id in
+/// whatever order they arrive. The table does not track time: the owner schedules each request's deadline
+/// (e.g. in a TimingWheel) and fails the entry when it passes. Completions are always invoked outside the
+/// table's lock, exactly once per entry: with the response, or with std::nullopt if it failed or the
+/// connection went away. Matching only needs the peeked envelope; the payload is copied into the
+/// Response once it has an owner and is decoded only by completions that look at it.
+/// Entries live in a small ring indexed by the low bits of the transaction id. The ids come from one
+/// process-wide counter (see TransactionId), so a client's own ids are not consecutive but still spread over
+/// the slots; an id whose slot is taken by another outstanding request goes to the overflow map.
+class InFlightTable {
+public:
+    using Completion = std::function<void(std::optional<Response>)>;
+
+    /// \brief Number of ring slots; a power of two. Allocated on the first request.
+    static constexpr size_t RING_SIZE = 64;
+
+    /// \brief Registers a request. If `transaction_id` is already in flight the completion fails right away
+    /// and false is returned.
+    bool Insert(const size_t transaction_id, const uint16_t opcode, Completion completion) {
+        {
+            std::lock_guard lock(mutex);
+            if (Find(transaction_id) == nullptr) {
+                if (!ring) {
+                    ring = std::make_unique<Slot[]>(RING_SIZE);
+                }
+                Slot &slot = ring[transaction_id & (RING_SIZE - 1)];
+                Entry &entry = slot.is_used ? overflow[transaction_id] : slot.entry;
+                if (!slot.is_used) {
+                    slot.is_used = true;
+                    slot.transaction_id = transaction_id;
+                }
+                entry = Entry{opcode, std::move(completion)};
+                ++size;
+                return true;
+            }
+        }
+        completion(std::nullopt);
+        return false;
+    }
+
+    /// \brief Completes the entry the response belongs to. `opcode` is the envelope's action, resolved to
+    /// the opcode table if the peer named it; requests outside the table (e.g. a batch) are NAMED_OPCODE on
+    /// both sides. Returns false for late or unknown responses.
+    bool Complete(const MessageEnvelope &envelope, const uint16_t opcode) {
+        Completion completion;
+        {
+            std::lock_guard lock(mutex);
+            const Entry *entry = Find(envelope.transaction_id);
+            if (entry == nullptr || opcode != entry->opcode) {
+                return false;
+            }
+            completion = Take(envelope.transaction_id);
+        }
+        completion(Response(envelope));
+        return true;
+    }
+
+    /// \brief Fails a single entry, e.g. because its request could not be sent or its deadline passed.
+    /// Does nothing if the entry already completed.
+    void Fail(const size_t transaction_id) {
+        Completion completion;
+        {
+            std::lock_guard lock(mutex);
+            if (Find(transaction_id) == nullptr) {
+                return;
+            }
+            completion = Take(transaction_id);
+        }
+        completion(std::nullopt);
+    }
+
+    /// \brief Fails everything, e.g. because the connection closed.
+    void FailAll() {
+        std::vector<Completion> failed;
+        {
+            std::lock_guard lock(mutex);
+            failed.reserve(size);
+            if (ring) {
+                for (size_t index = 0; index < RING_SIZE; ++index) {
+                    if (Slot &slot = ring[index]; slot.is_used) {
+                        failed.push_back(std::move(slot.entry.completion));
+                        slot.is_used = false;
+                        slot.entry = {};
+                    }
+                }
+            }
+            for (auto &entry: overflow | std::views::values) {
+                failed.push_back(std::move(entry.completion));
+            }
+            overflow.clear();
+            size = 0;
+        }
+        for (const auto &completion: failed) {
+            completion(std::nullopt);
+        }
+    }
+
+    size_t Size() {
+        std::lock_guard lock(mutex);
+        return size;
+    }
+
+private:
+    struct Entry {
+        uint16_t opcode = NAMED_OPCODE;
+        Completion completion;
+    };
+
+    struct Slot {
+        bool is_used = false;
+        size_t transaction_id = 0;
+        Entry entry;
+    };
+
+    /// \brief The caller must hold the mutex.
+    Entry *Find(const size_t transaction_id) {
+        if (!ring) {
+            return nullptr;
+        }
+        if (Slot &slot = ring[transaction_id & (RING_SIZE - 1)]; slot.is_used && slot.transaction_id == transaction_id) {
+            return &slot.entry;
+        }
+        const auto it = overflow.find(transaction_id);
+        return it == overflow.end() ? nullptr : &it->second;
+    }
+
+    /// \brief Removes an entry that is known to exist. The caller must hold the mutex.
+    Completion Take(const size_t transaction_id) {
+        Completion completion;
+        Slot &slot = ring[transaction_id & (RING_SIZE - 1)];
+        if (slot.is_used && slot.transaction_id == transaction_id) {
+            completion = std::move(slot.entry.completion);
+            slot.is_used = false;
+            slot.entry = {};
+        } else {
+            const auto it = overflow.find(transaction_id);
+            completion = std::move(it->second.completion);
+            overflow.erase(it);
+        }
+        --size;
+        return completion;
+    }
+
+    std::mutex mutex;
+    std::unique_ptr<Slot[]> ring;
+    std::unordered_map<size_t, Entry> overflow;
+    size_t size = 0;
+};
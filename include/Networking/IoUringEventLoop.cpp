@@ -0,0 +1,606 @@
+#include "IoUringEventLoop.h"
+
+#if HAS_IO_URING
+#include <csignal>
+#include <ranges>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+namespace {
+    constexpr int POLL_TIMEOUT_MS = 100;
+    constexpr auto SHUTDOWN_GRACE = std::chrono::seconds(1);
+
+    int io_uring_setup(const unsigned entries, io_uring_params *params) {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int io_uring_enter(const int fd, const unsigned to_submit, const unsigned min_complete, const unsigned flags,
+                       const void *arg, const size_t arg_size) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size));
+    }
+
+    int io_uring_register(const int fd, const unsigned opcode, const void *arg, const unsigned nr_args) {
+        return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+    }
+}
+
+// -----------------============RING============----------------- //
+void IoUringEventLoop::Ring::Setup(const unsigned entries) {
+    io_uring_params params{};
+    fd = io_uring_setup(entries, &params);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("io_uring_setup failed: ") + std::strerror(errno));
+    }
+    if (!(params.features & IORING_FEAT_EXT_ARG)) {
+        Destroy();
+        throw std::runtime_error("kernel does not support IORING_FEAT_EXT_ARG");
+    }
+
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+    }
+
+    sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq_ring == MAP_FAILED) {
+        sq_ring = nullptr;
+        Destroy();
+        throw std::runtime_error("mmap of the submission ring failed");
+    }
+    cq_ring = single_mmap
+                  ? sq_ring
+                  : mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                         IORING_OFF_CQ_RING);
+    if (cq_ring == MAP_FAILED) {
+        cq_ring = nullptr;
+        Destroy();
+        throw std::runtime_error("mmap of the completion ring failed");
+    }
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes_ptr = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes_ptr == MAP_FAILED) {
+        Destroy();
+        throw std::runtime_error("mmap of the submission entries failed");
+    }
+    sqes = static_cast<io_uring_sqe *>(sqes_ptr);
+
+    auto *sq = static_cast<char *>(sq_ring);
+    sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    sq_entries = params.sq_entries;
+    sq_local_tail = *sq_tail;
+
+    auto *cq = static_cast<char *>(cq_ring);
+    cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+}
+
+void IoUringEventLoop::Ring::Destroy() {
+    if (sqes) munmap(sqes, sqes_size);
+    if (cq_ring && cq_ring != sq_ring) munmap(cq_ring, cq_ring_size);
+    if (sq_ring) munmap(sq_ring, sq_ring_size);
+    if (fd >= 0) close(fd);
+    sqes = nullptr;
+    sq_ring = cq_ring = nullptr;
+    fd = -1;
+}
+
+io_uring_sqe *IoUringEventLoop::Ring::NextSqe() {
+    if (sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries) {
+        Submit();
+        if (sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries) {
+            return nullptr;
+        }
+    }
+
+    const unsigned index = sq_local_tail & *sq_mask;
+    io_uring_sqe *sqe = &sqes[index];
+    sq_array[index] = index;
+    ++sq_local_tail;
+    ++to_submit;
+
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+void IoUringEventLoop::Ring::Submit() {
+    __atomic_store_n(sq_tail, sq_local_tail, __ATOMIC_RELEASE);
+    while (to_submit > 0) {
+        const int submitted = io_uring_enter(fd, to_submit, 0, 0, nullptr, 0);
+        if (submitted < 0) {
+            if (errno == EINTR) continue;
+            // EBUSY/EAGAIN: the kernel wants completions reaped first; the entries stay queued.
+            return;
+        }
+        to_submit -= std::min<unsigned>(to_submit, submitted);
+    }
+}
+
+void IoUringEventLoop::Ring::SubmitAndWait(const int timeout_ms) {
+    __atomic_store_n(sq_tail, sq_local_tail, __ATOMIC_RELEASE);
+
+    __kernel_timespec timeout{};
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+
+    io_uring_getevents_arg arg{};
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = reinterpret_cast<uint64_t>(&timeout);
+
+    const int submitted = io_uring_enter(fd, to_submit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                                         &arg, sizeof(arg));
+    if (submitted > 0) {
+        to_submit -= std::min<unsigned>(to_submit, submitted);
+    }
+}
+
+// -----------------============LIFETIME============----------------- //
+IoUringEventLoop::IoUringEventLoop(const size_t worker_count) {
+    try {
+        for (size_t i = 0; i < std::max<size_t>(worker_count, 1); ++i) {
+            auto worker = std::make_unique<Worker>();
+            worker->ring.Setup(RING_ENTRIES);
+            workers.push_back(std::move(worker));
+            Worker &created = *workers.back();
+
+            created.wake_fd = eventfd(0, EFD_CLOEXEC);
+            if (created.wake_fd < 0) {
+                throw std::runtime_error("eventfd failed");
+            }
+
+            created.buffers = std::make_unique_for_overwrite<char[]>(REGISTERED_BUFFER_COUNT * REGISTERED_BUFFER_SIZE);
+            std::vector<iovec> registered(REGISTERED_BUFFER_COUNT);
+            for (size_t index = 0; index < REGISTERED_BUFFER_COUNT; ++index) {
+                registered[index] = {created.buffers.get() + index * REGISTERED_BUFFER_SIZE, REGISTERED_BUFFER_SIZE};
+                created.free_buffers.push_back(static_cast<int>(index));
+            }
+            if (io_uring_register(created.ring.fd, IORING_REGISTER_BUFFERS, registered.data(),
+                                  static_cast<unsigned>(registered.size())) < 0) {
+                throw std::runtime_error(std::string("buffer registration failed: ") + std::strerror(errno));
+            }
+        }
+    } catch (...) {
+        for (const auto &worker: workers) {
+            worker->ring.Destroy();
+            if (worker->wake_fd >= 0) close(worker->wake_fd);
+        }
+        throw;
+    }
+}
+
+IoUringEventLoop::~IoUringEventLoop() {
+    Stop();
+    for (const auto &worker: workers) {
+        worker->ring.Destroy();
+        if (worker->wake_fd >= 0) close(worker->wake_fd);
+        worker->wake_fd = -1;
+    }
+}
+
+void IoUringEventLoop::Start(Handlers handlers) {
+    on_frame = std::move(handlers.on_frame);
+    on_close = std::move(handlers.on_close);
+    on_accept = std::move(handlers.on_accept);
+    on_tick = std::move(handlers.on_tick);
+    is_running = true;
+
+    for (const auto &worker: workers) {
+        worker->thread = std::thread(&IoUringEventLoop::RunWorker, this, std::ref(*worker));
+    }
+}
+
+void IoUringEventLoop::Stop() {
+    if (!is_running.exchange(false)) {
+        return;
+    }
+    for (const auto &worker: workers) {
+        Wake(*worker);
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void IoUringEventLoop::Listen(const SOCKET listener) {
+    // The first worker starts queueing accepts on its next pass.
+    listen_socket = listener;
+    Wake(*workers.front());
+}
+
+std::shared_ptr<Connection> IoUringEventLoop::Add(const SOCKET socket, const size_t id, FrameBuffer &&buffer) {
+    // Sockets stay blocking: io_uring arms its own poll when an operation cannot complete right away.
+    auto connection = std::make_shared<Connection>(socket, id, std::move(buffer));
+
+    // Frames that arrived before the socket was handed over are already sitting in the buffer.
+    DispatchFrames(connection);
+
+    Register(connection);
+    return connection;
+}
+
+void IoUringEventLoop::Register(const std::shared_ptr<Connection> &connection) {
+    connection->worker_index = next_worker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+    Worker &worker = *workers[connection->worker_index];
+    {
+        std::lock_guard lock(worker.pending_mutex);
+        worker.pending_adds.push_back(connection);
+    }
+    Wake(worker);
+}
+
+void IoUringEventLoop::Adopt(const SOCKET socket) {
+    const auto connection = std::make_shared<Connection>(socket, 0, FrameBuffer{});
+    // The accept handler has to see the connection before a worker can deliver its first frame.
+    if (on_accept) {
+        on_accept(connection);
+    }
+    Register(connection);
+}
+
+DataStatus IoUringEventLoop::Send(const std::shared_ptr<Connection> &connection, SharedPayload payload) {
+    if (payload->size() > MAX_FRAME_SIZE) {
+        return DataStatus::DataNotSent;
+    }
+    {
+        std::lock_guard lock(connection->send_mutex);
+        if (!connection->IsOpen()) {
+            return DataStatus::DataNotSent;
+        }
+        connection->send_queue.emplace_back(std::move(payload));
+    }
+
+    // Sends are batched: the worker picks up every scheduled connection in one pass.
+    if (!connection->flush_scheduled.exchange(true)) {
+        Worker &worker = *workers[connection->worker_index];
+        {
+            std::lock_guard lock(worker.pending_mutex);
+            worker.pending_flushes.push_back(connection);
+        }
+        Wake(worker);
+    }
+    return DataStatus::DataSent;
+}
+
+// -----------------============WORKERS============----------------- //
+void IoUringEventLoop::Wake(Worker &worker) const {
+    if (!worker.wake_pending.exchange(true)) {
+        constexpr uint64_t one = 1;
+        [[maybe_unused]] const auto written = write(worker.wake_fd, &one, sizeof(one));
+    }
+}
+
+void IoUringEventLoop::RunWorker(Worker &worker) {
+    const bool is_first_worker = &worker == workers.front().get();
+    auto last_tick = std::chrono::steady_clock::now();
+    SubmitWakeRead(worker);
+
+    while (is_running) {
+        TakePending(worker);
+        if (is_first_worker && listen_socket != INVALID_SOCKET &&
+            std::chrono::steady_clock::now() >= worker.accept_retry_after) {
+            // Top the accept batch back up; each completion used one entry.
+            while (worker.accepts_in_flight < ACCEPT_BATCH && SubmitAccept(worker)) {
+            }
+        }
+        worker.ring.SubmitAndWait(POLL_TIMEOUT_MS);
+        ReapCompletions(worker);
+        if (is_first_worker) {
+            MaybeTick(last_tick);
+        }
+    }
+
+    Shutdown(worker);
+}
+
+void IoUringEventLoop::TakePending(Worker &worker) {
+    std::vector<std::shared_ptr<Connection> > adds;
+    std::vector<std::shared_ptr<Connection> > flushes;
+    {
+        std::lock_guard lock(worker.pending_mutex);
+        adds.swap(worker.pending_adds);
+        flushes.swap(worker.pending_flushes);
+    }
+
+    for (auto &connection: adds) {
+        auto state = std::make_unique<UringConnection>();
+        state->connection = connection;
+        UringConnection &created = *state;
+        worker.connections[connection->socket] = std::move(state);
+        if (!SubmitPoll(worker, created)) {
+            BeginClose(worker, created);
+        }
+    }
+
+    for (const auto &connection: flushes) {
+        connection->flush_scheduled = false;
+        const auto it = worker.connections.find(connection->socket);
+        if (it == worker.connections.end() || it->second->connection != connection) continue;
+
+        UringConnection &state = *it->second;
+        if (!state.send_in_flight && !state.closing && !SubmitSend(worker, state)) {
+            BeginClose(worker, state);
+        }
+    }
+}
+
+void IoUringEventLoop::ReapCompletions(Worker &worker) {
+    Ring &ring = worker.ring;
+    unsigned head = *ring.cq_head;
+    const unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        const io_uring_cqe &cqe = ring.cqes[head & *ring.cq_mask];
+        const uint64_t user_data = cqe.user_data;
+        const int result = cqe.res;
+        ++head;
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+
+        HandleCompletion(worker, user_data, result);
+    }
+}
+
+void IoUringEventLoop::HandleCompletion(Worker &worker, const uint64_t user_data, const int result) {
+    const auto operation = static_cast<Operation>(user_data & OPERATION_MASK);
+    if (operation == Operation::Wake) {
+        worker.wake_pending = false;
+        if (is_running) {
+            SubmitWakeRead(worker);
+        }
+        return;
+    }
+    if (operation == Operation::Accept) {
+        --worker.accepts_in_flight;
+        if (result >= 0 && is_running) {
+            Adopt(result);
+        } else if (result >= 0) {
+            closesocket(result);
+        } else if (result != -ECANCELED && result != -EINTR) {
+            std::cout << "Error... Accept failed: " << std::strerror(-result) << "\n";
+            worker.accept_retry_after = std::chrono::steady_clock::now() + TICK_INTERVAL;
+        }
+        return;
+    }
+
+    auto &state = *reinterpret_cast<UringConnection *>(user_data & ~OPERATION_MASK);
+    --state.pending_operations;
+
+    switch (operation) {
+        case Operation::Poll:
+            if (state.closing || result < 0 || !SubmitRead(worker, state)) {
+                BeginClose(worker, state);
+            }
+            return;
+
+        case Operation::Read: {
+            const int buffer_index = state.buffer_index;
+            state.buffer_index = -1;
+
+            bool is_healthy = result > 0;
+            if (is_healthy) {
+                if (buffer_index >= 0) {
+                    const char *bytes = worker.buffers.get() + static_cast<size_t>(buffer_index) * REGISTERED_BUFFER_SIZE;
+                    is_healthy = Deliver(state, {bytes, static_cast<size_t>(result)});
+                } else {
+                    state.connection->recv_buffer.CommitWrite(static_cast<size_t>(result));
+                    is_healthy = DispatchFrames(state.connection);
+                }
+            }
+            if (buffer_index >= 0) {
+                worker.free_buffers.push_back(buffer_index);
+            }
+
+            if (!is_healthy || state.closing) {
+                BeginClose(worker, state);
+                return;
+            }
+            // A full read means more bytes are probably waiting; otherwise wait for readiness again.
+            const bool more_pending = static_cast<size_t>(result) == state.read_size;
+            if (!(more_pending ? SubmitRead(worker, state) : SubmitPoll(worker, state))) {
+                BeginClose(worker, state);
+            }
+            return;
+        }
+
+        case Operation::Send: {
+            state.send_in_flight = false;
+            if (result < 0 && result != -EAGAIN && result != -EINTR) {
+                BeginClose(worker, state);
+                return;
+            }
+
+            bool has_more;
+            {
+                std::lock_guard lock(state.connection->send_mutex);
+                if (result > 0) {
+                    ConsumeSendQueue(*state.connection, static_cast<size_t>(result));
+                }
+                has_more = !state.connection->send_queue.empty();
+            }
+            if (state.closing) {
+                BeginClose(worker, state);
+            } else if (has_more && !SubmitSend(worker, state)) {
+                BeginClose(worker, state);
+            }
+            return;
+        }
+
+        default:
+            return;
+    }
+}
+
+bool IoUringEventLoop::SubmitPoll(Worker &worker, UringConnection &state) {
+    io_uring_sqe *sqe = worker.ring.NextSqe();
+    if (!sqe) return false;
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = state.connection->socket;
+    sqe->poll32_events = POLLIN | POLLRDHUP;
+    sqe->user_data = Tag(&state, Operation::Poll);
+    ++state.pending_operations;
+    return true;
+}
+
+bool IoUringEventLoop::SubmitRead(Worker &worker, UringConnection &state) {
+    io_uring_sqe *sqe = worker.ring.NextSqe();
+    if (!sqe) return false;
+
+    FrameBuffer &buffer = state.connection->recv_buffer;
+    sqe->fd = state.connection->socket;
+    sqe->user_data = Tag(&state, Operation::Read);
+
+    if (buffer.Readable() == 0 && !worker.free_buffers.empty()) {
+        // Nothing half-received: land the bytes in a registered buffer.
+        state.buffer_index = worker.free_buffers.back();
+        worker.free_buffers.pop_back();
+        state.read_size = REGISTERED_BUFFER_SIZE;
+
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->addr = reinterpret_cast<uint64_t>(worker.buffers.get() +
+                                               static_cast<size_t>(state.buffer_index) * REGISTERED_BUFFER_SIZE);
+        sqe->len = REGISTERED_BUFFER_SIZE;
+        sqe->buf_index = static_cast<uint16_t>(state.buffer_index);
+    } else {
+        // The rest of a partial frame goes straight into the FrameBuffer, sized for the whole frame.
+        const std::span<char> space = buffer.PrepareWrite();
+        state.read_size = std::min<size_t>(space.size(), UINT32_MAX);
+
+        sqe->opcode = IORING_OP_READ;
+        sqe->addr = reinterpret_cast<uint64_t>(space.data());
+        sqe->len = static_cast<uint32_t>(state.read_size);
+    }
+    ++state.pending_operations;
+    return true;
+}
+
+bool IoUringEventLoop::SubmitSend(Worker &worker, UringConnection &state) {
+    {
+        std::lock_guard lock(state.connection->send_mutex);
+        if (state.connection->send_queue.empty()) {
+            return true;
+        }
+        state.message = {};
+        state.message.msg_iov = state.iov;
+        state.message.msg_iovlen = GatherSendQueue(*state.connection, state.iov, MAX_IOV);
+    }
+
+    io_uring_sqe *sqe = worker.ring.NextSqe();
+    if (!sqe) return false;
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = state.connection->socket;
+    sqe->addr = reinterpret_cast<uint64_t>(&state.message);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = Tag(&state, Operation::Send);
+    state.send_in_flight = true;
+    ++state.pending_operations;
+    return true;
+}
+
+void IoUringEventLoop::SubmitWakeRead(Worker &worker) {
+    io_uring_sqe *sqe = worker.ring.NextSqe();
+    if (!sqe) return;
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = worker.wake_fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&worker.wake_value);
+    sqe->len = sizeof(worker.wake_value);
+    sqe->user_data = Tag(nullptr, Operation::Wake);
+}
+
+bool IoUringEventLoop::SubmitAccept(Worker &worker) const {
+    io_uring_sqe *sqe = worker.ring.NextSqe();
+    if (!sqe) return false;
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listen_socket;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = Tag(nullptr, Operation::Accept);
+    ++worker.accepts_in_flight;
+    return true;
+}
+
+bool IoUringEventLoop::Deliver(UringConnection &state, std::string_view bytes) const {
+    FrameBuffer &buffer = state.connection->recv_buffer;
+
+    // Fast path: whole frames are handed out as views into the registered buffer.
+    if (buffer.Readable() == 0) {
+        while (bytes.size() >= FRAME_HEADER_SIZE) {
+            const size_t payload_size = ReadFrameHeader(bytes.data());
+            if (payload_size > MAX_FRAME_SIZE) {
+                std::cout << "Error... Oversized frame announced on socket: " << state.connection->socket << "\n";
+                return false;
+            }
+            if (bytes.size() < FRAME_HEADER_SIZE + payload_size) break;
+
+            on_frame(state.connection, bytes.substr(FRAME_HEADER_SIZE, payload_size));
+            bytes.remove_prefix(FRAME_HEADER_SIZE + payload_size);
+        }
+    }
+
+    buffer.Append(bytes);
+    return DispatchFrames(state.connection);
+}
+
+void IoUringEventLoop::BeginClose(Worker &worker, UringConnection &state) {
+    const std::shared_ptr<Connection> connection = state.connection;
+
+    if (!state.closing) {
+        state.closing = true;
+        {
+            std::lock_guard lock(connection->send_mutex);
+            connection->is_open.store(false, std::memory_order_release);
+        }
+        // Completes the outstanding poll/send so their completions can be reaped.
+        shutdown(connection->socket, SHUT_RDWR);
+    }
+    if (state.pending_operations > 0) {
+        return;
+    }
+
+    // The kernel holds no reference to the send queue or the buffers any more.
+    {
+        std::lock_guard lock(connection->send_mutex);
+        connection->send_queue.clear();
+    }
+    worker.connections.erase(connection->socket);
+    closesocket(connection->socket);
+
+    if (on_close) {
+        on_close(connection);
+    }
+}
+
+void IoUringEventLoop::Shutdown(Worker &worker) {
+    std::vector<UringConnection *> open_connections;
+    for (const auto &state: worker.connections | std::views::values) {
+        open_connections.push_back(state.get());
+    }
+    for (UringConnection *state: open_connections) {
+        BeginClose(worker, *state);
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + SHUTDOWN_GRACE;
+    while (!worker.connections.empty() && std::chrono::steady_clock::now() < deadline) {
+        worker.ring.SubmitAndWait(POLL_TIMEOUT_MS);
+        ReapCompletions(worker);
+    }
+
+    // Anything still here is cancelled when the ring is torn down.
+    for (const auto &state: worker.connections | std::views::values) {
+        closesocket(state->connection->socket);
+    }
+    worker.connections.clear();
+}
+
+#endif
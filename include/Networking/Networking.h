@@ -1,3 +1,18 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <variant>
+
+#include <json/json.hpp>
+#include <Networking/Codec.h>
+#include <Networking/FrameBuffer.h>
+
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
@@ -6,6 +21,8 @@
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <cerrno>
+#include <sys/uio.h>
 #define SOCKET int
 #define SOCKET_ERROR (-1)
 #define INVALID_SOCKET (-1)
@@ -21,34 +38,98 @@ enum class DataStatus {
     DataReceived = 2,
     DataNotReceived = 3,
     UnknownSentError = 4,
-    UnknownReceivedError = 5
+    UnknownReceivedError = 5,
+    ConnectionClosed = 6,
+    InvalidFrame = 7
 };
 
+using json = nlohmann::json;
+
+/// \brief Immutable serialized payload. One buffer can sit in many send queues at once, e.g. for a broadcast.
+using SharedPayload = std::shared_ptr<const std::string>;
+
+// Writes one frame (header + payload) to the socket, looping over partial writes.
+// `bytes_written` reports how much reached the socket, so callers know whether a retry is still safe.
+// A payload above MAX_FRAME_SIZE is refused before anything is written, as the peer would drop it as corrupt.
+inline bool SendFrame(const SOCKET socket, const std::string_view payload, size_t &bytes_written) {
+    bytes_written = 0;
+    if (payload.size() > MAX_FRAME_SIZE) {
+        return false;
+    }
+    char header[FRAME_HEADER_SIZE];
+    WriteFrameHeader(header, payload.size());
+    const size_t total = FRAME_HEADER_SIZE + payload.size();
+
+    while (bytes_written < total) {
+#ifdef _WIN32
+        const bool in_header = bytes_written < FRAME_HEADER_SIZE;
+        const char *chunk = in_header ? header + bytes_written : payload.data() + (bytes_written - FRAME_HEADER_SIZE);
+        const size_t chunk_size = in_header ? FRAME_HEADER_SIZE - bytes_written : total - bytes_written;
+        const int sent = send(socket, chunk, static_cast<int>(chunk_size), 0);
+        if (sent == SOCKET_ERROR) {
+            return false;
+        }
+#else
+        iovec iov[2];
+        int iov_count = 0;
+        if (bytes_written < FRAME_HEADER_SIZE) {
+            iov[iov_count++] = {header + bytes_written, FRAME_HEADER_SIZE - bytes_written};
+            iov[iov_count++] = {const_cast<char *>(payload.data()), payload.size()};
+        } else {
+            const size_t offset = bytes_written - FRAME_HEADER_SIZE;
+            iov[iov_count++] = {const_cast<char *>(payload.data()) + offset, payload.size() - offset};
+        }
+        msghdr message{};
+        message.msg_iov = iov;
+        message.msg_iovlen = iov_count;
+
+        const ssize_t sent = sendmsg(socket, &message, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+#endif
+        bytes_written += static_cast<size_t>(sent);
+    }
+    return true;
+}
+
 template<typename FlagType = std::atomic<bool> >
 DataStatus SendData(
     const SOCKET &socket,
     const std::variant<std::string, json> &data,
     std::optional<std::shared_ptr<FlagType> > success_flag = std::nullopt,
-    const int max_retries = 5,
-    const int wait_time = 1) {
-    const auto &actual_data = data.index() == 0 ? std::get<std::string>(data) : std::get<json>(data).dump();
+    const int max_retries = 5) {
     try {
+        const std::string dumped = data.index() == 0 ? std::string{} : std::get<json>(data).dump();
+        const std::string_view actual_data = data.index() == 0 ? std::string_view{std::get<std::string>(data)} : dumped;
+        if (actual_data.size() > MAX_FRAME_SIZE) {
+            std::cout << "Error... Payload of " << actual_data.size() << " bytes exceeds the frame limit\n";
+            if (success_flag) success_flag.value()->store(false, std::memory_order_relaxed);
+            return DataStatus::DataNotSent;
+        }
+
         for (int attempt = 0; attempt < max_retries; ++attempt) {
             // Check if socket is closed
             if (socket == INVALID_SOCKET) {
                 if (success_flag) success_flag.value()->store(false, std::memory_order_relaxed);
                 return DataStatus::DataNotSent;
             }
-            const int bytes_sent = send(socket, actual_data.c_str(), static_cast<int>(actual_data.size()), 0);
-            if (bytes_sent != SOCKET_ERROR) {
+            size_t bytes_written = 0;
+            if (SendFrame(socket, actual_data, bytes_written)) {
                 if (success_flag) success_flag.value()->store(true, std::memory_order_relaxed);
                 return DataStatus::DataSent;
             }
 
-            // Print error and retry
+            // A partially written frame cannot be resent without corrupting the stream.
+            if (bytes_written > 0) {
+                std::cout << "Error... Connection broke mid-frame on socket: " << socket << "\n";
+                break;
+            }
+
+            // Print error and retry right away; waiting would not mend the socket, it only held the caller up.
             std::cout << "Error... Failed to send to socket: " << socket << ". Attempt: " << attempt + 1 << "\n";
             if (success_flag) success_flag.value()->store(false, std::memory_order_relaxed);
-            std::this_thread::sleep_for(std::chrono::seconds(wait_time));
         }
     } catch (const std::exception &) {
         if (success_flag) success_flag.value()->store(false, std::memory_order_relaxed);
@@ -59,34 +140,54 @@ DataStatus SendData(
     return DataStatus::DataNotSent;
 }
 
+/// \brief Receives the next complete frame from `socket` into the connection's FrameBuffer.
+/// \details `frame` is a view into `buffer` and stays valid until the next RecvData on the same buffer.
+/// Frames that already arrived glued to a previous read are returned without touching the socket.
 template<typename FlagType = std::atomic<bool> >
 DataStatus RecvData(
     const SOCKET &socket,
-    std::string &data,
+    FrameBuffer &buffer,
+    std::string_view &frame,
     std::optional<std::shared_ptr<FlagType> > success_flag = std::nullopt,
-    const int buffer_size = 1024,
-    const int max_retries = 5,
-    const int wait_time = 1) {
+    const int max_retries = 5) {
     try {
-        char buffer[buffer_size];
-        for (int attempt = 0; attempt < max_retries; ++attempt) {
+        int attempt = 0;
+        while (attempt < max_retries) {
+            if (const auto next = buffer.NextFrame()) {
+                frame = *next;
+                if (success_flag) success_flag.value()->store(true, std::memory_order_relaxed);
+                return DataStatus::DataReceived;
+            }
+            if (buffer.IsCorrupted()) {
+                std::cout << "Error... Oversized frame announced on socket: " << socket << "\n";
+                if (success_flag) success_flag.value()->store(false, std::memory_order_relaxed);
+                return DataStatus::InvalidFrame;
+            }
+
             // Check if socket is closed
             if (socket == INVALID_SOCKET) {
                 if (success_flag) success_flag.value()->store(false, std::memory_order_relaxed);
-                return DataStatus::DataNotSent;
+                return DataStatus::DataNotReceived;
             }
 
-            const int bytes_received = recv(socket, buffer, buffer_size, 0);
+            const std::span<char> space = buffer.PrepareWrite();
+            const int bytes_received = recv(socket, space.data(), static_cast<int>(std::min<size_t>(space.size(), INT32_MAX)), 0);
             if (bytes_received > 0) {
-                data.assign(buffer, bytes_received);
-                if (success_flag) success_flag.value()->store(true, std::memory_order_relaxed);
-                return DataStatus::DataReceived;
+                buffer.CommitWrite(static_cast<size_t>(bytes_received));
+                continue;
+            }
+            if (bytes_received == 0) {
+                if (success_flag) success_flag.value()->store(false, std::memory_order_relaxed);
+                return DataStatus::ConnectionClosed;
             }
+#ifndef _WIN32
+            if (errno == EINTR) continue;
+#endif
 
-            // Print error and retry
+            // Print error and retry right away
             std::cout << "Error... Failed to receive from socket: " << socket << ". Attempt: " << attempt + 1 << "\n";
             if (success_flag) success_flag.value()->store(false, std::memory_order_relaxed);
-            std::this_thread::sleep_for(std::chrono::seconds(wait_time));
+            ++attempt;
         }
     } catch (const std::exception &) {
         if (success_flag) success_flag.value()->store(false, std::memory_order_relaxed);
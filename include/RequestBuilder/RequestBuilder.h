@@ -1,5 +1,43 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+#include <Actions/Action.h>
 #include <Actions/ActionSystem.h>
+#include <Networking/Networking.h>
+
+/// \brief Lock-free source of transaction ids: the process epoch above a 40-bit counter.
+/// \details Ids never repeat within a process, and the epoch (low 24 bits of the startup time in
+/// milliseconds, mixed with a random salt) keeps them apart from earlier runs, so a response to a request sent
+/// before a restart cannot match a new one, even if both runs started within the same second. The counter is
+/// shared by every connection, so one client's ids are unique but not consecutive.
+class TransactionId {
+public:
+    static constexpr unsigned COUNTER_BITS = 40;
+    static constexpr uint64_t COUNTER_MASK = (uint64_t{1} << COUNTER_BITS) - 1;
+
+    static size_t Next() {
+        return epoch | (counter.fetch_add(1, std::memory_order_relaxed) & COUNTER_MASK);
+    }
+
+private:
+    static uint64_t MakeEpoch() {
+        const auto milliseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        // The salt leaves the low 10 bits, the sub-second part, to the clock; only the low 24 bits survive.
+        const uint64_t salt = std::random_device{}();
+        return (milliseconds ^ salt << 10) << COUNTER_BITS;
+    }
+
+    inline static const uint64_t epoch = MakeEpoch();
+    inline static std::atomic<uint64_t> counter{1};
+};
 
 class Request {
 public:
@@ -22,6 +60,7 @@ public:
 
         result["transaction_id"] = transaction_id;
         this->action_name = action_name;
+        opcode = action_registry.OpcodeOf(action_name).value_or(NAMED_OPCODE);
         result["index"] = action_name;
         if (id != nullptr) {
             result["id"] = *id;
@@ -31,6 +70,26 @@ public:
         }
 
         body = result.dump();
+        message = std::move(result);
+        payloads = {};
+    }
+
+    /// \brief The request encoded in `codec`, with "index" as the opcode if the peer agreed to opcodes. Each
+    /// encoding is produced on first use and then shared by every send, so a broadcast encodes once per wire
+    /// format in use rather than once per client.
+    const SharedPayload &Payload(const Codec codec, const bool use_opcodes = false) const {
+        const bool by_opcode = use_opcodes && opcode != NAMED_OPCODE;
+        SharedPayload &payload = payloads[static_cast<size_t>(codec) * 2 + by_opcode];
+        if (!payload) {
+            if (by_opcode) {
+                json numbered = message;
+                numbered["index"] = opcode;
+                payload = std::make_shared<const std::string>(EncodeMessage(numbered, codec));
+            } else {
+                payload = std::make_shared<const std::string>(codec == Codec::Json ? body : EncodeMessage(message, codec));
+            }
+        }
+        return payload;
     }
 
     static nlohmann::json GetJsonFromRequest(const Request &request);
@@ -78,9 +137,144 @@ public:
 
 public:
     std::string action_name;
-    std::hash<std::string> hasher;
-    size_t transaction_id = hasher(std::to_string(std::chrono::system_clock::now().time_since_epoch().count()));
+    size_t transaction_id = TransactionId::Next();
+
+    /// \brief Position in the opcode table; NAMED_OPCODE for actions that are not in it.
+    uint16_t opcode = NAMED_OPCODE;
+
+    /// \brief JSON text of the request; also the Codec::Json payload.
     std::string body;
+
+    json message;
+
+private:
+    /// \brief By codec, then named or numbered.
+    mutable std::array<SharedPayload, CODEC_COUNT * 2> payloads;
+};
+
+/// \brief Collects several actions into one BATCH_REQUEST, so a playbook of small commands costs a single
+/// round trip. The client answers with one response holding every result in the order the actions were added.
+class BatchBuilder {
+public:
+    /// \brief A sequential batch runs its actions one after the other, in order; otherwise they run at once.
+    explicit BatchBuilder(const bool sequential = false) : sequential(sequential) {
+    }
+
+    void Add(const std::string &action_name, const json &data) {
+        json action;
+        action["index"] = action_name;
+        if (!data.empty()) {
+            action["data"] = data;
+        }
+        actions.push_back(std::move(action));
+    }
+
+    size_t Size() const { return actions.size(); }
+
+    Request Build() const {
+        json data;
+        data["sequential"] = sequential;
+        data["actions"] = actions;
+        return Request(std::string(BATCH_REQUEST), data);
+    }
+
+private:
+    bool sequential;
+    json actions = json::array();
+};
+
+/// \brief A request that is sent over and over with only the transaction_id changing, e.g. a status probe.
+/// \details Encoded once per codec with a placeholder id. Sending copies those bytes and writes the real id
+/// over the placeholder: the JSON number is left-aligned and padded with spaces, MessagePack and CBOR keep
+/// the full 8-byte unsigned form, and the binary envelope starts with the id anyway.
+class RequestTemplate {
+public:
+    /// \brief Takes the widest form in every codec, so any real id fits in its place.
+    static constexpr uint64_t PLACEHOLDER_ID = std::numeric_limits<uint64_t>::max();
+    static constexpr size_t JSON_ID_WIDTH = std::numeric_limits<uint64_t>::digits10 + 1;
+
+    RequestTemplate(std::string action_name, const json &data)
+        : action_name(std::move(action_name)),
+          opcode(action_registry.OpcodeOf(this->action_name).value_or(NAMED_OPCODE)) {
+        json message;
+        message["transaction_id"] = PLACEHOLDER_ID;
+        if (!data.empty()) {
+            message["data"] = data;
+        }
+
+        for (size_t index = 0; index < encodings.size(); ++index) {
+            const auto codec = static_cast<Codec>(index / 2);
+            if (index % 2 == 1 && opcode != NAMED_OPCODE) {
+                message["index"] = opcode;
+            } else {
+                message["index"] = this->action_name;
+            }
+            Encoded &encoded = encodings[index];
+            encoded.bytes = EncodeMessage(message, codec);
+            encoded.id_offset = FindPlaceholder(encoded.bytes, codec);
+        }
+    }
+
+    /// \brief The request with `transaction_id`, encoded in `codec` and numbered if the peer agreed to opcodes.
+    /// One copy of the template, nothing else.
+    SharedPayload Instantiate(const Codec codec, const bool use_opcodes, const uint64_t transaction_id) const {
+        const Encoded &encoded = encodings[static_cast<size_t>(codec) * 2 + use_opcodes];
+        auto payload = std::make_shared<std::string>(encoded.bytes);
+        char *id = payload->data() + encoded.id_offset;
+
+        switch (codec) {
+            case Codec::Json: {
+                const auto end = std::to_chars(id, id + JSON_ID_WIDTH, transaction_id).ptr;
+                std::fill(end, id + JSON_ID_WIDTH, ' ');
+                break;
+            }
+            case Codec::Binary:
+                for (size_t byte = 0; byte < sizeof(uint64_t); ++byte) {
+                    id[byte] = static_cast<char>(transaction_id >> byte * 8 & 0xFF);
+                }
+                break;
+            default:
+                for (size_t byte = 0; byte < sizeof(uint64_t); ++byte) {
+                    id[byte] = static_cast<char>(transaction_id >> (7 - byte) * 8 & 0xFF);
+                }
+                break;
+        }
+        return payload;
+    }
+
+    const std::string &ActionName() const { return action_name; }
+
+    uint16_t Opcode() const { return opcode; }
+
+private:
+    struct Encoded {
+        std::string bytes;
+        size_t id_offset = 0;
+    };
+
+    /// \brief Offset of the placeholder id's value bytes. Object keys are sorted, so "transaction_id" is the
+    /// last member and its occurrence is found from the back even if the data happens to contain the same bytes.
+    static size_t FindPlaceholder(const std::string &bytes, const Codec codec) {
+        if (codec == Codec::Binary) {
+            return 0;
+        }
+
+        // The member on its own: a one-member map without its header (and for JSON, without the braces).
+        const std::string lone = EncodeMessage(json{{"transaction_id", PLACEHOLDER_ID}}, codec);
+        const std::string_view member = std::string_view(lone).substr(1, lone.size() - (codec == Codec::Json ? 2 : 1));
+        const size_t position = bytes.rfind(member);
+        if (position == std::string::npos) {
+            throw std::logic_error("Transaction id placeholder not found in the " + std::string(CodecName(codec)) +
+                                   " template");
+        }
+        return position + member.size() - (codec == Codec::Json ? JSON_ID_WIDTH : sizeof(uint64_t));
+    }
+
+    std::string action_name;
+    uint16_t opcode;
+
+    /// \brief By codec, then named or numbered.
+    std::array<Encoded, CODEC_COUNT * 2> encodings;
 };
 
 inline nlohmann::json Request::GetJsonFromRequest(const Request &request) {
@@ -0,0 +1,77 @@
+#include "NetworkWatcher.h"
+
+#include <array>
+#include <iostream>
+#if defined(__linux__)
+#include <cerrno>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+
+void NetworkWatcher::Start(std::function<void()> callback) {
+#if defined(__linux__)
+    if (is_running) {
+        return;
+    }
+    netlink_socket = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (netlink_socket < 0) {
+        std::cerr << "Network watcher unavailable: cannot open a netlink socket\n";
+        return;
+    }
+
+    sockaddr_nl address{};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if (bind(netlink_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        std::cerr << "Network watcher unavailable: cannot subscribe to link and address changes\n";
+        close(netlink_socket);
+        netlink_socket = -1;
+        return;
+    }
+
+    on_change = std::move(callback);
+    is_running = true;
+    thread = std::thread(&NetworkWatcher::Run, this);
+#else
+    (void) callback;
+#endif
+}
+
+void NetworkWatcher::Stop() {
+    if (!is_running.exchange(false)) {
+        return;
+    }
+    thread.join();
+#if defined(__linux__)
+    close(netlink_socket);
+#endif
+    netlink_socket = -1;
+}
+
+void NetworkWatcher::Run() {
+#if defined(__linux__)
+    std::array<char, 8192> buffer{};
+    while (is_running) {
+        pollfd descriptor{netlink_socket, POLLIN, 0};
+        if (poll(&descriptor, 1, POLL_INTERVAL_MS) <= 0) {
+            continue;
+        }
+
+        // Only the fact that something changed matters, so a burst of messages counts as one change.
+        // ENOBUFS means messages were dropped, which is a change as well.
+        bool has_changed = false;
+        ssize_t received;
+        while ((received = recv(netlink_socket, buffer.data(), buffer.size(), MSG_DONTWAIT)) > 0 ||
+               (received < 0 && errno == ENOBUFS)) {
+            has_changed = true;
+        }
+        if (has_changed) {
+            on_change();
+        }
+    }
+#endif
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <thread>
+
+
+/// \brief Calls `on_change` on its own thread whenever a network interface or address changes.
+/// \details Listens to rtnetlink on Linux. Elsewhere Start does nothing and data that depends on the
+/// network is only refreshed when it expires.
+class NetworkWatcher final {
+public:
+    ~NetworkWatcher() { Stop(); }
+
+    void Start(std::function<void()> on_change);
+
+    void Stop();
+
+    /// \brief How often the watcher thread checks whether it should stop.
+    static constexpr int POLL_INTERVAL_MS = 500;
+
+private:
+    void Run();
+
+    std::function<void()> on_change;
+    std::atomic<bool> is_running = false;
+    int netlink_socket = -1;
+    std::thread thread;
+};
@@ -1,4 +1,7 @@
 #include "OperatingSystemManager.h"
+#include "ShellPool.h"
+
+#include <memory>
 
 #include <format>
 #if defined(_WIN32) || defined(_WIN64)
@@ -6,35 +9,333 @@
 #else
 #define _popen popen
 #define _pclose pclose
+
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace {
+    /// Size of each read from a command's pipes.
+    constexpr size_t READ_CHUNK = 256 * 1024;
+
+    /// Requested pipe buffer size; Linux defaults to 64 KiB.
+    constexpr int PIPE_CAPACITY = 1024 * 1024;
+}
 #endif
 
+#if defined(__linux__)
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <ranges>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <netinet/in.h>
+
+// ----------------------------------========Native Collectors========---------------------------------- //
+// Read the kernel's view directly instead of forking tools for it. Each produces exactly what the shell
+// pipeline it replaces printed, so the status looks the same either way.
+namespace {
+    std::string ReadFirstLine(const std::filesystem::path &path) {
+        std::ifstream file(path);
+        std::string line;
+        std::getline(file, line);
+        return line;
+    }
+
+    // Like `ifconfig | grep 'inet ' | awk '{print $2}'`: every IPv4 address, one per line, with interfaces
+    // sorted by name as ifconfig lists them. getifaddrs asks the kernel over rtnetlink.
+    std::string CollectIPv4Addresses() {
+        ifaddrs *addresses = nullptr;
+        if (getifaddrs(&addresses) != 0) {
+            return {};
+        }
+        std::vector<std::pair<std::string, std::string> > found;
+        for (const ifaddrs *entry = addresses; entry != nullptr; entry = entry->ifa_next) {
+            if (entry->ifa_addr == nullptr || entry->ifa_addr->sa_family != AF_INET) {
+                continue;
+            }
+            std::array<char, INET_ADDRSTRLEN> text{};
+            const auto *address = reinterpret_cast<const sockaddr_in *>(entry->ifa_addr);
+            if (inet_ntop(AF_INET, &address->sin_addr, text.data(), text.size()) != nullptr) {
+                found.emplace_back(entry->ifa_name, text.data());
+            }
+        }
+        freeifaddrs(addresses);
+        std::ranges::stable_sort(found, {}, &std::pair<std::string, std::string>::first);
+
+        std::string result;
+        for (const auto &address: found | std::views::values) {
+            result += address + "\n";
+        }
+        return result;
+    }
+
+    // Like `ip -o link | awk '{print $2 $17}'`: "<interface>:<mac>" per line, ordered by interface index.
+    std::string CollectLinkAddresses() {
+        struct Link {
+            int index;
+            std::string name;
+            std::string address;
+        };
+        std::vector<Link> links;
+
+        std::error_code error;
+        for (const auto &entry: std::filesystem::directory_iterator("/sys/class/net", error)) {
+            Link link;
+            link.name = entry.path().filename().string();
+            link.address = ReadFirstLine(entry.path() / "address");
+            try {
+                link.index = std::stoi(ReadFirstLine(entry.path() / "ifindex"));
+            } catch (const std::exception &) {
+                continue;
+            }
+            links.push_back(std::move(link));
+        }
+        std::ranges::sort(links, {}, &Link::index);
+
+        std::string result;
+        for (const auto &link: links) {
+            result += link.name + ":" + link.address + "\n";
+        }
+        return result;
+    }
+
+    // Like `grep ^PRETTY_NAME /etc/os-release | cut -d= -f2`: the value as written, quotes included.
+    std::string CollectOSName() {
+        for (const char *path: {"/etc/os-release", "/usr/lib/os-release"}) {
+            std::ifstream file(path);
+            std::string line;
+            while (std::getline(file, line)) {
+                if (line.starts_with("PRETTY_NAME=")) {
+                    return line.substr(std::string_view("PRETTY_NAME=").size()) + "\n";
+                }
+            }
+        }
+        return {};
+    }
+}
+#endif
+
+
+namespace {
+    /// Set once by EnableShellPool before any action runs, then only read.
+    std::unique_ptr<ShellPool> shell_pool;
+}
+
+void OperatingSystemManager::EnableShellPool(const size_t sessions) {
+    shell_pool = sessions > 0 ? std::make_unique<ShellPool>(sessions) : nullptr;
+}
+
+CommandOutput OperatingSystemManager::RunShellCommand(const std::string &command, const CommandLimits &limits) {
+    return shell_pool ? shell_pool->Run(command, limits) : SpawnCommand(command, limits);
+}
 
 std::string OperatingSystemManager::ExecuteCommand(const std::string &command) {
-    std::array<char, 128> buffer{};
-    std::string result;
-    FILE *pipe = _popen((command + " 2>&1").c_str(), "r"); // Redirect stderr to stdout
-    if (!pipe) return "Error executing command";
-    try {
-        while (fgets(buffer.data(), buffer.size(), pipe) != nullptr) {
-            result += buffer.data();
-        }
-    } catch (...) {
-        _pclose(pipe);
-        throw;
+    CommandLimits limits;
+    limits.merge_stderr = true;
+    return SpawnCommand(command, limits).output;
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+// No pipes to poll here: the output is read through popen and the limits only cap the size.
+CommandOutput OperatingSystemManager::SpawnCommand(const std::string &command, const CommandLimits &limits) {
+    CommandOutput result;
+    FILE *pipe = _popen((limits.merge_stderr ? command + " 2>&1" : command).c_str(), "r");
+    if (!pipe) {
+        result.errors = "Error executing command";
+        return result;
+    }
+    std::array<char, 64 * 1024> buffer{};
+    size_t read;
+    while ((read = fread(buffer.data(), 1, buffer.size(), pipe)) > 0) {
+        const size_t kept = std::min(read, limits.max_output - result.output.size());
+        result.output.append(buffer.data(), kept);
+        if (kept < read) {
+            result.truncated = true;
+            break;
+        }
     }
-    _pclose(pipe);
+    result.exit_code = _pclose(pipe);
     return result;
 }
+#else
+CommandOutput OperatingSystemManager::SpawnCommand(const std::string &command, const CommandLimits &limits) {
+    using Clock = std::chrono::steady_clock;
+    CommandOutput result;
+
+    int out_pipe[2] = {-1, -1};
+    int err_pipe[2] = {-1, -1};
+    if (pipe2(out_pipe, O_CLOEXEC) != 0 || (!limits.merge_stderr && pipe2(err_pipe, O_CLOEXEC) != 0)) {
+        for (const int fd: {out_pipe[0], out_pipe[1], err_pipe[0], err_pipe[1]}) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+        result.errors = "Error executing command: no pipe";
+        return result;
+    }
+#if defined(F_SETPIPE_SZ)
+    // Fewer, larger reads for chatty commands. Only a hint: the kernel may refuse.
+    fcntl(out_pipe[0], F_SETPIPE_SZ, PIPE_CAPACITY);
+#endif
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, limits.merge_stderr ? out_pipe[1] : err_pipe[1], STDERR_FILENO);
+
+    // Its own process group, so a timeout also reaches whatever the shell started. SIGPIPE goes back to its
+    // default in case this process ignores it (see ShellPool).
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t default_signals;
+    sigemptyset(&default_signals);
+    sigaddset(&default_signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attributes, &default_signals);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF);
+    posix_spawnattr_setpgroup(&attributes, 0);
+
+    const char *argv[] = {"sh", "-c", command.c_str(), nullptr};
+    pid_t pid = -1;
+    const int spawn_error = posix_spawn(&pid, "/bin/sh", &actions, &attributes, const_cast<char *const *>(argv),
+                                        environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
+
+    close(out_pipe[1]);
+    if (err_pipe[1] >= 0) {
+        close(err_pipe[1]);
+    }
+    if (spawn_error != 0) {
+        close(out_pipe[0]);
+        if (err_pipe[0] >= 0) {
+            close(err_pipe[0]);
+        }
+        result.errors = "Error executing command: " + std::string(strerror(spawn_error));
+        return result;
+    }
+
+    const auto deadline = Clock::now() + limits.timeout;
+    bool is_killed = false;
+    const auto kill_group = [&] {
+        if (!is_killed) {
+            kill(-pid, SIGKILL);
+            is_killed = true;
+        }
+    };
+
+    // Reused by every command on this thread; only the bytes read are appended to the result.
+    thread_local std::vector<char> buffer(READ_CHUNK);
+
+    std::array<pollfd, 2> streams{{{out_pipe[0], POLLIN, 0}, {err_pipe[0], POLLIN, 0}}};
+    std::array<std::string *, 2> targets{&result.output, &result.errors};
+    size_t open_streams = err_pipe[0] >= 0 ? 2 : 1;
+
+    while (open_streams > 0 && !is_killed) {
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+        if (remaining.count() <= 0) {
+            result.timed_out = true;
+            kill_group();
+            break;
+        }
+        if (poll(streams.data(), streams.size(), static_cast<int>(remaining.count())) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            kill_group();
+            break;
+        }
+
+        for (size_t index = 0; index < streams.size(); ++index) {
+            pollfd &stream = streams[index];
+            if (stream.fd < 0 || stream.revents == 0) {
+                continue;
+            }
+            const ssize_t read_size = read(stream.fd, buffer.data(), buffer.size());
+            if (read_size < 0 && errno == EINTR) {
+                continue;
+            }
+            if (read_size <= 0) {
+                close(stream.fd);
+                stream.fd = -1;
+                --open_streams;
+                continue;
+            }
+
+            const size_t room = limits.max_output - result.output.size() - result.errors.size();
+            const size_t kept = std::min(static_cast<size_t>(read_size), room);
+            targets[index]->append(buffer.data(), kept);
+            if (kept < static_cast<size_t>(read_size)) {
+                result.truncated = true;
+                kill_group();
+                break;
+            }
+        }
+    }
+    for (const auto &stream: streams) {
+        if (stream.fd >= 0) {
+            close(stream.fd);
+        }
+    }
+
+    // The command may have closed its output and still be running.
+    int status = 0;
+    while (true) {
+        const pid_t waited = waitpid(pid, &status, is_killed ? 0 : WNOHANG);
+        if (waited == pid) {
+            break;
+        }
+        if (waited < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // `status` was never filled in; exit_code stays -1 rather than reading as a success.
+            result.errors += "Error waiting for command: " + std::string(strerror(errno));
+            return result;
+        }
+        if (Clock::now() >= deadline) {
+            result.timed_out = true;
+            kill_group();
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    if (WIFEXITED(status)) {
+        result.exit_code = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        result.exit_code = 128 + WTERMSIG(status);
+    }
+    return result;
+}
+#endif
 
 std::string OperatingSystemManager::GetClientIP() {
 #if _WIN32
     const std::string command = "powershell -Command \"Get-WmiObject win32_networkadapterconfiguration | "
             "Where-Object {$_.IPAddress -ne $null} | "
             "Select-Object -ExpandProperty IPAddress | Select-Object -First 1\"";
+    return ExecuteCommand(command);
+#elif defined(__linux__)
+    return CollectIPv4Addresses();
 #else
     const std::string command = "ifconfig | grep 'inet ' | awk '{print $2}'";
-#endif
     return ExecuteCommand(command);
+#endif
 }
 
 std::string OperatingSystemManager::GetClientMAC() {
@@ -42,21 +343,25 @@ std::string OperatingSystemManager::GetClientMAC() {
     const std::string command = "powershell -Command \"Get-WmiObject win32_networkadapterconfiguration | "
             "Where-Object {$_.MACAddress -ne $null} | "
             "Select-Object -ExpandProperty MACAddress | Select-Object -First 1\"";
+    return ExecuteCommand(command);
+#elif defined(__linux__)
+    return CollectLinkAddresses();
 #else
     const std::string command = "ip -o link | awk '{print $2 $17}'";
-#endif
-
     return ExecuteCommand(command);
+#endif
 }
 
 std::string OperatingSystemManager::GetClientOS() {
 #if _WIN32
     const std::string command = "powershell -Command \"(Get-WmiObject Win32_OperatingSystem).Caption\"";
+    return ExecuteCommand(command);
+#elif defined(__linux__)
+    return CollectOSName();
 #else
     const std::string command = "grep ^PRETTY_NAME /etc/os-release | cut -d= -f2 | tr -d ''";
-#endif
-
     return ExecuteCommand(command);
+#endif
 }
 
 std::string OperatingSystemManager::GetClientCPUSerial() {
@@ -2,16 +2,55 @@
 #include <iostream>
 #include <array>
 #include <algorithm>
+#include <chrono>
+#include <string>
 
 
+/// \brief Bounds for SpawnCommand.
+struct CommandLimits {
+    /// \brief The command and everything it started are killed once this has passed.
+    std::chrono::milliseconds timeout = std::chrono::seconds(60);
+
+    /// \brief Combined size of stdout and stderr kept; the command is killed when it writes more.
+    size_t max_output = 64 * 1024 * 1024;
+
+    /// \brief Send stderr into `output` as well, interleaved as written, like `2>&1`.
+    bool merge_stderr = false;
+};
+
+/// \brief What a command printed and how it ended.
+struct CommandOutput {
+    std::string output;
+    std::string errors;
+
+    /// \brief Exit code, or 128 + signal number if the command was killed (like the shell reports it);
+    /// -1 if it could not be started.
+    int exit_code = -1;
+
+    bool timed_out = false;
+    bool truncated = false;
+};
+
 class OperatingSystemManager final {
 public:
+    /// \brief Runs `command` through the shell with stdin from /dev/null, reading stdout and stderr on their
+    /// own pipes in large chunks.
+    static CommandOutput SpawnCommand(const std::string &command, const CommandLimits &limits = {});
+
     static std::string GetClientIP();
 
     static std::string GetClientMAC();
 
     static std::string GetClientOS();
 
+    /// \brief Opt-in: keeps `sessions` shells running for RunShellCommand, so short commands skip the cost
+    /// of starting a shell. Call once at startup, before any action runs.
+    static void EnableShellPool(size_t sessions);
+
+    /// \brief Runs `command` in a pooled shell session if the pool is enabled, otherwise like SpawnCommand.
+    static CommandOutput RunShellCommand(const std::string &command, const CommandLimits &limits = {});
+
+    /// \brief Output of `command` with stderr merged in, within the default limits.
     static std::string ExecuteCommand(const std::string &command);
 
     static std::string GetClientCPUSerial();
@@ -0,0 +1,290 @@
+#include "ShellPool.h"
+
+#include <array>
+#include <chrono>
+#include <random>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <csignal>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+#endif
+
+ShellSession::ShellSession() {
+    std::random_device random;
+    token = "__shell_session_" + std::to_string(uint64_t{random()} << 32 | random()) + "__";
+}
+
+ShellSession::~ShellSession() {
+    Stop();
+}
+
+#if defined(_WIN32)
+bool ShellSession::Start() {
+    return false;
+}
+
+void ShellSession::Stop() {
+}
+
+std::optional<CommandOutput> ShellSession::Run(const std::string &, const CommandLimits &) {
+    return std::nullopt;
+}
+#else
+namespace {
+    /// Same read and pipe sizes as SpawnCommand.
+    constexpr size_t READ_CHUNK = 256 * 1024;
+    constexpr int PIPE_CAPACITY = 1024 * 1024;
+
+    /// Quotes `text` for the shell: inside single quotes only the quote itself needs escaping.
+    std::string SingleQuoted(const std::string &text) {
+        std::string quoted = "'";
+        for (const char c: text) {
+            if (c == '\'') {
+                quoted += "'\\''";
+            } else {
+                quoted += c;
+            }
+        }
+        quoted += "'";
+        return quoted;
+    }
+
+    bool WriteAll(const int fd, const std::string_view data) {
+        size_t written = 0;
+        while (written < data.size()) {
+            const ssize_t result = write(fd, data.data() + written, data.size() - written);
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result <= 0) {
+                return false;
+            }
+            written += static_cast<size_t>(result);
+        }
+        return true;
+    }
+}
+
+bool ShellSession::Start() {
+    int in_pipe[2], out_pipe[2], err_pipe[2];
+    if (pipe2(in_pipe, O_CLOEXEC) != 0) {
+        return false;
+    }
+    if (pipe2(out_pipe, O_CLOEXEC) != 0) {
+        close(in_pipe[0]);
+        close(in_pipe[1]);
+        return false;
+    }
+    if (pipe2(err_pipe, O_CLOEXEC) != 0) {
+        for (const int fd: {in_pipe[0], in_pipe[1], out_pipe[0], out_pipe[1]}) {
+            close(fd);
+        }
+        return false;
+    }
+
+#if defined(F_SETPIPE_SZ)
+    fcntl(out_pipe[0], F_SETPIPE_SZ, PIPE_CAPACITY);
+#endif
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, in_pipe[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, err_pipe[1], STDERR_FILENO);
+
+    // Own process group for killing it whole; SIGPIPE back to default, since the pool ignores it here.
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t default_signals;
+    sigemptyset(&default_signals);
+    sigaddset(&default_signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attributes, &default_signals);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF);
+    posix_spawnattr_setpgroup(&attributes, 0);
+
+    const char *argv[] = {"sh", nullptr};
+    pid_t child = -1;
+    const int spawn_error = posix_spawn(&child, "/bin/sh", &actions, &attributes, const_cast<char *const *>(argv),
+                                        environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
+
+    close(in_pipe[0]);
+    close(out_pipe[1]);
+    close(err_pipe[1]);
+    if (spawn_error != 0) {
+        close(in_pipe[1]);
+        close(out_pipe[0]);
+        close(err_pipe[0]);
+        return false;
+    }
+
+    pid = child;
+    input = in_pipe[1];
+    output = out_pipe[0];
+    errors = err_pipe[0];
+    return true;
+}
+
+void ShellSession::Stop() {
+    if (pid < 0) {
+        return;
+    }
+    kill(-pid, SIGKILL);
+    for (const int fd: {input, output, errors}) {
+        close(fd);
+    }
+    waitpid(pid, nullptr, 0);
+    pid = input = output = errors = -1;
+}
+
+std::optional<CommandOutput> ShellSession::Run(const std::string &command, const CommandLimits &limits) {
+    using Clock = std::chrono::steady_clock;
+    if (pid < 0 && !Start()) {
+        return std::nullopt;
+    }
+
+    const std::string marker = token + ":" + std::to_string(++sequence);
+    const std::string script = "( eval " + SingleQuoted(command) + " ) </dev/null" +
+                               (limits.merge_stderr ? " 2>&1" : "") +
+                               "; printf '%s:%s\\n' '" + marker + "' \"$?\"; printf '%s\\n' '" + marker + "' >&2\n";
+    if (!WriteAll(input, script)) {
+        // The shell is gone; nothing of this command has run yet.
+        Stop();
+        if (!Start() || !WriteAll(input, script)) {
+            Stop();
+            return std::nullopt;
+        }
+    }
+
+    CommandOutput result;
+    const std::string out_marker = marker + ":";
+    const std::string err_marker = marker + "\n";
+    std::optional<size_t> out_end;
+    std::optional<size_t> err_end;
+    // The status follows the stdout sentinel; stdout is done once the rest of that line is in.
+    bool is_out_complete = false;
+
+    thread_local std::vector<char> buffer(READ_CHUNK);
+    std::array<pollfd, 2> streams{{{output, POLLIN, 0}, {errors, POLLIN, 0}}};
+    const auto deadline = Clock::now() + limits.timeout;
+
+    const auto abandon = [&](const int exit_code) {
+        Stop();
+        result.exit_code = exit_code;
+        if (out_end) {
+            result.output.resize(*out_end);
+        }
+        if (err_end) {
+            result.errors.resize(*err_end);
+        }
+        return result;
+    };
+
+    while (!is_out_complete || !err_end) {
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+        if (remaining.count() <= 0) {
+            result.timed_out = true;
+            return abandon(128 + SIGKILL);
+        }
+        streams[0].fd = is_out_complete ? -1 : output;
+        streams[1].fd = err_end ? -1 : errors;
+        if (poll(streams.data(), streams.size(), static_cast<int>(remaining.count())) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return abandon(-1);
+        }
+
+        for (size_t index = 0; index < streams.size(); ++index) {
+            if (streams[index].fd < 0 || streams[index].revents == 0) {
+                continue;
+            }
+            const ssize_t read_size = read(streams[index].fd, buffer.data(), buffer.size());
+            if (read_size < 0 && errno == EINTR) {
+                continue;
+            }
+            if (read_size <= 0) {
+                result.errors += "Shell session ended unexpectedly\n";
+                return abandon(-1);
+            }
+
+            std::string &target = index == 0 ? result.output : result.errors;
+            const std::string &sentinel = index == 0 ? out_marker : err_marker;
+            std::optional<size_t> &end = index == 0 ? out_end : err_end;
+            // The sentinel may straddle two reads.
+            const size_t search_from = target.size() - std::min(target.size(), sentinel.size());
+            target.append(buffer.data(), static_cast<size_t>(read_size));
+
+            if (!end) {
+                if (const size_t found = target.find(sentinel, search_from); found != std::string::npos) {
+                    end = found;
+                }
+            }
+            if (index == 0 && out_end) {
+                is_out_complete = target.find('\n', *out_end + out_marker.size()) != std::string::npos;
+            }
+            // The sentinels themselves do not count against the cap.
+            if (result.output.size() + result.errors.size() > limits.max_output + 2 * out_marker.size() + 16) {
+                result.truncated = true;
+                result.output.resize(std::min(result.output.size(), limits.max_output));
+                result.errors.resize(std::min(result.errors.size(), limits.max_output - result.output.size()));
+                return abandon(128 + SIGKILL);
+            }
+        }
+    }
+
+    const size_t status_at = *out_end + out_marker.size();
+    const std::string_view status(result.output.data() + status_at,
+                                  result.output.find('\n', status_at) - status_at);
+    result.exit_code = std::atoi(std::string(status).c_str());
+    result.output.resize(*out_end);
+    result.errors.resize(*err_end);
+    if (result.output.size() + result.errors.size() > limits.max_output) {
+        result.truncated = true;
+        result.output.resize(std::min(result.output.size(), limits.max_output));
+        result.errors.resize(limits.max_output - result.output.size());
+    }
+    return result;
+}
+#endif
+
+ShellPool::ShellPool(const size_t size) {
+#if !defined(_WIN32)
+    // Writing to a shell that just died must fail with EPIPE rather than kill the agent.
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+    idle.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        idle.push_back(std::make_unique<ShellSession>());
+    }
+}
+
+CommandOutput ShellPool::Run(const std::string &command, const CommandLimits &limits) {
+    std::unique_ptr<ShellSession> session;
+    {
+        std::lock_guard lock(mutex);
+        if (!idle.empty()) {
+            session = std::move(idle.back());
+            idle.pop_back();
+        }
+    }
+    if (!session) {
+        return OperatingSystemManager::SpawnCommand(command, limits);
+    }
+
+    std::optional<CommandOutput> result = session->Run(command, limits);
+    {
+        std::lock_guard lock(mutex);
+        idle.push_back(std::move(session));
+    }
+    return result ? std::move(*result) : OperatingSystemManager::SpawnCommand(command, limits);
+}
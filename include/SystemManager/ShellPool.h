@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "OperatingSystemManager.h"
+
+
+/// \brief One long-lived `sh` that runs the commands written to its stdin, so a command costs a fork of a
+/// warm shell instead of spawning and starting a new one.
+/// \details Each command runs in a subshell through eval: `exit`, `cd` and syntax errors stay inside it, and
+/// it reads /dev/null rather than the session's stdin. After it, the shell prints a sentinel unique to the
+/// session and command, with the exit status, on stdout and on stderr; that is where the output ends.
+/// A session that runs past the timeout or the output cap is killed and started again on the next command.
+class ShellSession final {
+public:
+    ShellSession();
+
+    ~ShellSession();
+
+    ShellSession(const ShellSession &) = delete;
+
+    ShellSession &operator=(const ShellSession &) = delete;
+
+    /// \brief std::nullopt if no shell could be started; the caller then spawns the command itself.
+    std::optional<CommandOutput> Run(const std::string &command, const CommandLimits &limits);
+
+private:
+    bool Start();
+
+    /// \brief Kills the shell and everything it started.
+    void Stop();
+
+    int pid = -1;
+    int input = -1;
+    int output = -1;
+    int errors = -1;
+
+    std::string token;
+    uint64_t sequence = 0;
+};
+
+/// \brief Fixed set of shell sessions shared by all action workers.
+class ShellPool final {
+public:
+    explicit ShellPool(size_t size);
+
+    /// \brief Runs the command in an idle session. When every session is busy it is spawned as usual
+    /// rather than waiting for one.
+    CommandOutput Run(const std::string &command, const CommandLimits &limits = {});
+
+private:
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ShellSession> > idle;
+};
@@ -0,0 +1,73 @@
+#include "TimerThread.h"
+
+#include <memory>
+
+TimerThread::TimerThread() : thread(&TimerThread::Run, this) {
+}
+
+TimerThread::~TimerThread() {
+    Stop();
+}
+
+void TimerThread::Schedule(const Clock::time_point deadline, Task task) {
+    {
+        std::lock_guard lock(mutex);
+        if (is_stopping) {
+            return;
+        }
+        if (wheel.Size() == 0) {
+            // The wheel stood still while idle; catch it up so it does not walk every tick it missed.
+            wheel.Advance(Clock::now(), [](Task) {});
+        }
+        wheel.Schedule(std::move(task), deadline);
+    }
+    wake.notify_one();
+}
+
+bool TimerThread::WaitUntil(const Clock::time_point deadline) {
+    const auto is_due = std::make_shared<bool>(false);
+    Schedule(deadline, [this, is_due] {
+        {
+            std::lock_guard lock(mutex);
+            *is_due = true;
+        }
+        released.notify_all();
+    });
+
+    std::unique_lock lock(mutex);
+    released.wait(lock, [this, &is_due] { return *is_due || is_stopping; });
+    return *is_due;
+}
+
+void TimerThread::Stop() {
+    {
+        std::lock_guard lock(mutex);
+        is_stopping = true;
+    }
+    wake.notify_all();
+    released.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void TimerThread::Run() {
+    std::vector<Task> due;
+    std::unique_lock lock(mutex);
+    while (!is_stopping) {
+        if (wheel.Size() == 0) {
+            wake.wait(lock, [this] { return is_stopping || wheel.Size() > 0; });
+            continue;
+        }
+        wake.wait_for(lock, TICK_INTERVAL, [this] { return is_stopping; });
+        wheel.Advance(Clock::now(), [&due](Task task) { due.push_back(std::move(task)); });
+
+        // Tasks run without the lock, so they may schedule further tasks.
+        lock.unlock();
+        for (auto &task: due) {
+            task();
+        }
+        due.clear();
+        lock.lock();
+    }
+}
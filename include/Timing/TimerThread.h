@@ -0,0 +1,48 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "TimingWheel.h"
+
+
+/// \brief A TimingWheel with a thread of its own, for code that has no event loop to advance one, e.g. the
+/// client. Any number of timers cost one thread, which does not wake up while none are pending.
+class TimerThread final {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Task = std::move_only_function<void()>;
+
+    static constexpr auto TICK_INTERVAL = std::chrono::milliseconds(100);
+
+    TimerThread();
+
+    ~TimerThread();
+
+    TimerThread(const TimerThread &) = delete;
+
+    TimerThread &operator=(const TimerThread &) = delete;
+
+    /// \brief Runs `task` on the timer thread once `deadline` has passed. Tasks must not block.
+    void Schedule(Clock::time_point deadline, Task task);
+
+    /// \brief Blocks the calling thread until `deadline`. Returns false if the timer thread was stopped first.
+    bool WaitUntil(Clock::time_point deadline);
+
+    /// \brief Drops every pending task and releases every waiter.
+    void Stop();
+
+private:
+    void Run();
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable released;
+    bool is_stopping = false;
+    TimingWheel<Task> wheel{TICK_INTERVAL};
+
+    std::thread thread;
+};
@@ -0,0 +1,116 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// ----=== Timing wheel ===----
+/// \brief Hierarchical timing wheel: deadlines bucketed by tick, so scheduling is O(1) and advancing only
+/// looks at the slots of the ticks that passed.
+/// \details Level 0 has one slot per tick; each higher level has one slot per full turn of the level below.
+/// An entry sits at the lowest level whose span covers its deadline and moves down a level each time the
+/// wheel reaches its slot, so it is touched at most once per level. A deadline is rounded up to the next
+/// tick. Deadlines beyond the top level wait in its farthest slot and are placed again from there.
+/// Not thread-safe.
+template<typename Value>
+class TimingWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t SLOT_BITS = 6;
+    static constexpr size_t SLOTS = size_t{1} << SLOT_BITS;
+    static constexpr size_t LEVELS = 4;
+
+    explicit TimingWheel(const Clock::duration tick, const Clock::time_point start = Clock::now())
+        : tick(tick), origin(start) {
+    }
+
+    void Schedule(Value value, const Clock::time_point deadline) {
+        // Never into a tick that has already been processed.
+        Place({std::max(TickOf(deadline), current_tick + 1), std::move(value)});
+        ++size;
+    }
+
+    /// \brief Hands every value whose deadline has passed by `now` to `on_due`, in tick order. `on_due` may
+    /// schedule new values but must not advance the wheel.
+    template<typename OnDue>
+    void Advance(const Clock::time_point now, OnDue &&on_due) {
+        // Only ticks that have fully passed; a deadline is never reported early.
+        const uint64_t target_tick = now <= origin ? 0 : static_cast<uint64_t>((now - origin) / tick);
+        while (current_tick < target_tick) {
+            if (size == 0) {
+                // Nothing to cascade or fire on the way.
+                current_tick = target_tick;
+                return;
+            }
+            ++current_tick;
+            Cascade();
+
+            // Whatever is in the level 0 slot now is due at exactly this tick.
+            firing.swap(slots[0][current_tick & (SLOTS - 1)]);
+            size -= firing.size();
+            for (auto &entry: firing) {
+                on_due(std::move(entry.value));
+            }
+            firing.clear();
+        }
+    }
+
+    size_t Size() const { return size; }
+
+private:
+    struct Entry {
+        uint64_t due_tick;
+        Value value;
+    };
+
+    static constexpr uint64_t Span(const size_t level) {
+        return uint64_t{1} << SLOT_BITS * (level + 1);
+    }
+
+    uint64_t TickOf(const Clock::time_point time) const {
+        if (time <= origin) {
+            return 0;
+        }
+        return static_cast<uint64_t>((time - origin + tick - Clock::duration(1)) / tick);
+    }
+
+    void Place(Entry entry) {
+        const uint64_t delta = entry.due_tick - current_tick;
+        for (size_t level = 0; level < LEVELS; ++level) {
+            if (delta < Span(level)) {
+                slots[level][entry.due_tick >> SLOT_BITS * level & (SLOTS - 1)].push_back(std::move(entry));
+                return;
+            }
+        }
+        constexpr size_t top = LEVELS - 1;
+        const uint64_t farthest = current_tick + Span(top) - 1;
+        slots[top][farthest >> SLOT_BITS * top & (SLOTS - 1)].push_back(std::move(entry));
+    }
+
+    /// \brief When a level wraps, the next slot of the level above is spread over the levels below.
+    void Cascade() {
+        for (size_t level = 1; level < LEVELS; ++level) {
+            if ((current_tick >> SLOT_BITS * (level - 1) & (SLOTS - 1)) != 0) {
+                return;
+            }
+            cascading.swap(slots[level][current_tick >> SLOT_BITS * level & (SLOTS - 1)]);
+            for (auto &entry: cascading) {
+                Place(std::move(entry));
+            }
+            cascading.clear();
+        }
+    }
+
+    Clock::duration tick;
+    Clock::time_point origin;
+    uint64_t current_tick = 0;
+    size_t size = 0;
+    std::array<std::array<std::vector<Entry>, SLOTS>, LEVELS> slots;
+
+    /// \brief Scratch lists that keep their capacity between ticks.
+    std::vector<Entry> firing;
+    std::vector<Entry> cascading;
+};
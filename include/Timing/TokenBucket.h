@@ -0,0 +1,33 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+
+// ----=== Token bucket ===----
+/// \brief Allows `rate` units per second on average, in bursts of up to `burst` units. Not thread-safe.
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TokenBucket(const double rate, const double burst, const Clock::time_point start = Clock::now())
+        : rate(rate), burst(burst), tokens(burst), last_refill(start) {
+    }
+
+    /// \brief Takes `count` units if that many are available; otherwise takes nothing.
+    bool TryTake(const Clock::time_point now, const double count = 1) {
+        if (now > last_refill) {
+            tokens = std::min(burst, tokens + rate * std::chrono::duration<double>(now - last_refill).count());
+            last_refill = now;
+        }
+        if (tokens < count) {
+            return false;
+        }
+        tokens -= count;
+        return true;
+    }
+
+private:
+    double rate;
+    double burst;
+    double tokens;
+    Clock::time_point last_refill;
+};
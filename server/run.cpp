@@ -1,9 +1,40 @@
 #include "server.h"
 
-int main()
+#include <charconv>
+
+int main(int argc, char *argv[])
 {
-    Server server;
+    // Usage: server [--backend=epoll|io_uring] [--probe-budget=<probes per second>]
+    EventLoopBackend backend = EventLoopBackend::Epoll;
+    std::optional<size_t> probe_budget;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view argument = argv[i];
+        if (argument.starts_with("--probe-budget=")) {
+            const std::string_view value = argument.substr(std::string_view("--probe-budget=").size());
+            size_t budget = 0;
+            const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), budget);
+            if (error != std::errc{} || end != value.data() + value.size() || budget == 0) {
+                std::cerr << "Invalid probe budget: " << argument << "\n";
+                return 1;
+            }
+            probe_budget = budget;
+            continue;
+        }
+        if (argument.starts_with("--backend=")) {
+            const auto parsed = ParseEventLoopBackend(argument.substr(std::string_view("--backend=").size()));
+            if (!parsed) {
+                std::cerr << "Unknown backend: " << argument << "\n";
+                return 1;
+            }
+            backend = *parsed;
+        }
+    }
+
+    Server server(backend);
+    if (probe_budget) {
+        server.probe_budget = *probe_budget;
+    }
     server.StartServer();
 
     return true;
-}
\ No newline at end of file
+}
@@ -2,7 +2,7 @@
 
 
 // -----------------============NETWORKING============----------------- //
-Server::Server() {
+Server::Server(const EventLoopBackend backend) : event_loop(EventLoop::Create(backend)) {
     std::cout << "Server initialized.\n";
 }
 
@@ -45,241 +45,597 @@ void Server::StartServer() {
     std::cout << "Server listening on port " << PORT << "...\n";
     isRunning = true;
 
-    std::thread admin_thread(&Server::AdminThread, this, this);
+    // Status probes never change apart from their transaction id, so each is encoded once up front.
+    for (const auto &action: action_registry.status_update_actions) {
+        status_probes.emplace_back(action->getName(), action->serialize());
+    }
+    // A burst of one second's budget, and never less than one round.
+    probe_tokens.emplace(static_cast<double>(probe_budget),
+                         static_cast<double>(std::max(probe_budget, status_probes.size())));
+
+    event_loop->Start({
+        .on_frame = [this](const std::shared_ptr<Connection> &connection, const std::string_view frame) {
+            OnFrame(connection, frame);
+        },
+        .on_close = [this](const std::shared_ptr<Connection> &connection) {
+            OnConnectionClosed(connection);
+        },
+        .on_accept = [this](const std::shared_ptr<Connection> &connection) {
+            OnAccept(connection);
+        },
+        .on_tick = [this] {
+            OnTick();
+        }
+    });
+    event_loop->Listen(server_socket);
+    std::cout << "Event loop (" << event_loop->Name() << ") running with " << event_loop->WorkerCount()
+            << " worker(s).\n";
+
+    adminThread = std::thread(&Server::AdminThread, this, this);
+    adminThread.detach();
+
+    // Accepting and handshakes happen inside the event loop; this thread only waits for EndServer.
+    {
+        std::unique_lock lock(shutdown_mutex);
+        shutdown_cv.wait(lock, [this] { return !isRunning; });
+    }
 
-    sockaddr_in clientAddr{};
-    SOCKET client_socket{};
+    ReleaseResources();
+}
 
-    while (isRunning) {
-        socklen_t client_size = sizeof(clientAddr);
-        client_socket = accept(
-            server_socket,
-            reinterpret_cast<sockaddr *>(&clientAddr),
-            &client_size);
+// Only signals the shutdown; StartServer releases everything once it wakes up.
+void Server::EndServer() {
+    if (!isRunning.exchange(false)) {
+        return;
+    }
 
-        if (client_socket != INVALID_SOCKET) {
-            std::cout << "Client connected: " << inet_ntoa(clientAddr.sin_addr) << "\n";
+    {
+        std::lock_guard lock(shutdown_mutex);
+    }
+    shutdown_cv.notify_all();
+}
 
-            size_t client_id = 0;
-            bool is_admin = false;
+void Server::ReleaseResources() {
+    event_loop->Stop();
 
-            // Receiving client ID
-            while (true) {
-                std::string buffer(1024, '\0');
-                RecvData(client_socket, buffer);
-
-                try {
-                    json request = json::parse(buffer);
-
-                    // Check if the client is an admin
-                    if (request.contains("index") &&
-                        request.contains("data") &&
-                        request.at("index").is_string() &&
-                        request.at("index") == "AdminCredential") {
-                        if (request.contains("data")) {
-                            if (request.at("data") == AdminCredentialS{}) {
-                                client_id = request.at("id");
-                                is_admin = true;
-                                SendData(client_socket, ErrorMessageSendingClientIdS{Ok});
-                            } else {
-                                SendData(client_socket, ErrorMessageSendingClientIdS{Incorrect});
-                                throw std::invalid_argument("Invalid Admin credentials...");
-                            }
-                        }
-                    } else {
-                        if (request.contains("id") && request.at("id").is_number()) {
-                            client_id = request.at("id");
-                            SendData(client_socket, ErrorMessageSendingClientIdS{Ok});
-                            break;
-                        } else {
-                            SendData(client_socket, ErrorMessageSendingClientIdS{Incorrect});
-                            throw std::invalid_argument("Invalid ID");
-                        }
-                    }
-                } catch
-                (const std::exception &e) {
-                    std::cout << "Invalid ID. Client must resend their ID...\n";
-                    std::cerr << "Error: " << e.what() << "\n";
-                    SendData(client_socket, ErrorMessageSendingClientIdS{Incorrect});
-                }
+    for (const auto client: SnapshotClients()) {
+        client->is_client_connected = false;
+        client->in_flight.FailAll();
+    }
+    {
+        std::lock_guard lock(handshakes_mutex);
+        handshakes.clear();
+    }
+
+    closesocket(server_socket);
+    WSACleanup();
+}
+
+
+// -----------------============EVENT LOOP============----------------- //
+void Server::OnFrame(const std::shared_ptr<Connection> &connection, const std::string_view frame) {
+    if (!connection->is_identified.load(std::memory_order_acquire)) {
+        ProcessHandshake(connection, frame);
+        return;
+    }
+
+    ClientThreadData *client = FindClient(connection->id);
+    if (client == nullptr || client->GetConnection() != connection) {
+        return;
+    }
+
+    // Routing only reads the envelope; the payload is decoded later, and only if a completion asks for it.
+    const auto envelope = PeekEnvelope(frame, client->codec);
+    if (!envelope) {
+        std::cout << "Malformed or unroutable " << CodecName(client->codec) << " frame from client with id: "
+                << client->id << "\n";
+        return;
+    }
+    if (envelope->opcode == NAMED_OPCODE && (envelope->index == STATUS_PUSH || envelope->index == HEARTBEAT)) {
+        OnPush(client, *envelope);
+        return;
+    }
+    const uint16_t opcode = envelope->opcode != NAMED_OPCODE
+                                ? envelope->opcode
+                                : action_registry.OpcodeOf(envelope->index).value_or(NAMED_OPCODE);
+    if (!client->in_flight.Complete(*envelope, opcode)) {
+        std::cout << "Late or unknown response from client with id: " << client->id << "\n";
+    }
+}
+
+// Binary responses carry the result struct's fields; the action they answer knows their layout.
+bool Server::DecodeResponseFields(const BinaryEnvelope &envelope, BinaryReader &reader, json &out) {
+    const auto action = envelope.opcode != NAMED_OPCODE
+                            ? action_registry.AtOpcode(envelope.opcode)
+                            : action_registry.Find(envelope.name);
+    if (!action) {
+        return false;
+    }
+    out = action->deserializeFields(reader);
+    return true;
+}
+
+void Server::OnPush(ClientThreadData *client, const MessageEnvelope &envelope) {
+    if (envelope.index == STATUS_PUSH) {
+        uint64_t version = 0;
+        try {
+            version = client->ApplyStatusPush(envelope.DecodeData());
+            std::cout << "Status version " << version << " from client with id: " << client->id << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Malformed status from client with id: " << client->id << ": " << e.what() << "\n";
+            // Acknowledging the version the record still has makes the agent send its whole status.
+            version = client->GetStatusVersion();
+        }
+
+        json ack;
+        ack["transaction_id"] = 0;
+        ack["index"] = STATUS_ACK;
+        ack["data"] = {{"version", version}};
+        if (const auto connection = client->GetConnection()) {
+            event_loop->Send(connection, EncodeMessage(ack, client->codec));
+        }
+    }
+    client->last_push = std::chrono::steady_clock::now();
+    client->is_client_connected = true;
+    client->update_status_time();
+}
+
+void Server::OnConnectionClosed(const std::shared_ptr<Connection> &connection) {
+    if (!connection->is_identified.load(std::memory_order_acquire)) {
+        std::lock_guard lock(handshakes_mutex);
+        if (handshakes.erase(connection.get()) > 0) {
+            std::cout << "Client disconnected during handshake.\n";
+        }
+        return;
+    }
+
+    ClientThreadData *client = FindClient(connection->id);
+    if (client == nullptr || client->GetConnection() != connection) {
+        return;
+    }
+    std::cout << "Client with id: " << client->id << " disconnected\n";
+    client->is_client_connected = false;
+    // Stops the client's probes until it connects again.
+    ++client->probe_schedule;
+    client->update_status_time();
+    client->in_flight.FailAll();
+}
+
+void Server::OnAccept(const std::shared_ptr<Connection> &connection) {
+    sockaddr_in client_addr{};
+    socklen_t client_size = sizeof(client_addr);
+    if (getpeername(connection->socket, reinterpret_cast<sockaddr *>(&client_addr), &client_size) == 0) {
+        std::cout << "Client connected: " << inet_ntoa(client_addr.sin_addr) << "\n";
+    }
+
+    {
+        std::lock_guard lock(handshakes_mutex);
+        handshakes.emplace(connection.get(), PendingHandshake{connection});
+    }
+    ScheduleTimer(HandshakeDeadline{connection}, std::chrono::steady_clock::now() + HANDSHAKE_TIMEOUT);
+}
+
+void Server::OnTick() {
+    const auto now = std::chrono::steady_clock::now();
+    std::vector<ServerTimer> due;
+    {
+        std::lock_guard lock(timers_mutex);
+        timers.Advance(now, [&due](ServerTimer timer) { due.push_back(std::move(timer)); });
+    }
+
+    // Handled outside the lock: failing a request runs its completion, which may send and schedule again.
+    for (const auto &timer: due) {
+        if (const auto *handshake = std::get_if<HandshakeDeadline>(&timer)) {
+            const auto connection = handshake->connection.lock();
+            bool is_expired = false;
+            if (connection) {
+                // Connections that finished the handshake in the meantime are no longer in `handshakes`.
+                std::lock_guard lock(handshakes_mutex);
+                is_expired = handshakes.erase(connection.get()) > 0;
             }
-            // Check if the client is already connected
-            if (client_threads.contains(client_id)) {
-                auto &client_data = client_threads[client_id].first;
-                if (client_data->is_client_connected) {
-                    std::cout << "Client already connected. Closing previous connection.\n";
-                    std::cout << "Old client socket: " << client_data->client_socket << "\n";
-                    std::cout << "New client socket: " << client_socket << "\n";
-                    closesocket(client_data->client_socket);
-                }
-                client_data->client_socket = client_socket;
-                if (is_admin) {
-                    client_data->is_admin = true;
+            if (is_expired) {
+                std::cout << "Handshake timed out on socket: " << connection->socket << "\n";
+                EventLoop::Close(connection);
+            }
+        } else if (const auto *request = std::get_if<RequestDeadline>(&timer)) {
+            // Does nothing if the response arrived in time.
+            request->client->in_flight.Fail(request->transaction_id);
+        } else if (const auto *probe = std::get_if<ProbeDue>(&timer)) {
+            ClientThreadData *client = probe->client;
+            // A disconnect ends the schedule; the next handshake starts a new one.
+            if (probe->schedule != client->probe_schedule) {
+                continue;
+            }
+            // Requests other than probes in flight mean the client is busy, which warrants a closer watch.
+            if (client->in_flight.Size() > client->probes_in_flight) {
+                client->quiet_rounds = 0;
+            }
+            const auto last_push = client->last_push.load();
+            const bool has_pushed = last_push != std::chrono::steady_clock::time_point{};
+            if (has_pushed && now - last_push < PUSH_TIMEOUT) {
+                // The agent keeps the server up to date by itself, which says as much as a probe would.
+                // Look again once its next push is overdue.
+                ++client->quiet_rounds;
+                ScheduleTimer(ProbeDue{client, probe->schedule}, last_push + PUSH_TIMEOUT);
+                continue;
+            }
+            if (has_pushed) {
+                // An agent that stopped pushing is watched closely again.
+                client->quiet_rounds = 0;
+                client->last_push = std::chrono::steady_clock::time_point{};
+            }
+
+            auto next_round = now + ProbeInterval(*client);
+            // No probe goes out while the last round is still in flight.
+            if (client->probes_in_flight == 0) {
+                if (probe_tokens->TryTake(now, static_cast<double>(status_probes.size()))) {
+                    ++client->quiet_rounds;
+                    SendDueProbes(client);
+                } else {
+                    // Over the fleet's budget: the round waits for the tokens to refill.
+                    next_round = now + EventLoop::TICK_INTERVAL;
                 }
-                client_data->is_client_connected = true;
-            } else {
-                // Add new client
-                auto client_thread_data = std::make_unique<ClientThreadData>();
-                client_thread_data->id = client_id;
-                client_thread_data->client_socket = client_socket;
-                client_thread_data->is_client_connected = true;
-
-                client_threads[client_id] = std::make_pair(
-                    std::move(client_thread_data),
-                    std::thread(&Server::HandleClient, this));
             }
+            ScheduleTimer(ProbeDue{client, probe->schedule}, next_round);
         }
     }
 }
 
-void Server::EndServer() {
-    isRunning = false;
+void Server::ScheduleTimer(ServerTimer timer, const std::chrono::steady_clock::time_point deadline) {
+    std::lock_guard lock(timers_mutex);
+    timers.Schedule(std::move(timer), deadline);
+}
 
 
-    for (auto &[fst, snd]: client_threads | std::views::values) {
-        fst->is_client_connected = false;
-        snd.join();
-        closesocket(fst->client_socket);
+// -----------------============HANDSHAKE============----------------- //
+void Server::ProcessHandshake(const std::shared_ptr<Connection> &connection, const std::string_view frame) {
+    size_t client_id = 0;
+    bool is_admin = false;
+    bool is_valid = false;
+    Codec codec = Codec::Json;
+    bool uses_opcodes = false;
+
+    try {
+        // Handshake frames are always JSON; the codec and opcodes for everything after it are agreed here.
+        const json request = json::parse(frame);
+        codec = NegotiateCodec(request);
+        uses_opcodes = request.value("opcodes", false);
+
+        // Check if the client is an admin
+        if (request.contains("index") &&
+            request.at("index").is_string() &&
+            request.at("index") == "AdminCredential") {
+            is_admin = true;
+            if (request.contains("data") && request.at("data") == AdminCredentialS{} &&
+                request.contains("id") && request.at("id").is_number()) {
+                client_id = request.at("id");
+                is_valid = true;
+            }
+        } else if (request.contains("id") && request.at("id").is_number()) {
+            client_id = request.at("id");
+            is_valid = true;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
     }
 
+    bool is_rejected = false;
+    {
+        std::lock_guard lock(handshakes_mutex);
+        const auto it = handshakes.find(connection.get());
+        if (it == handshakes.end()) {
+            // Already timed out; the connection is on its way down.
+            return;
+        }
+        // Wrong admin credentials end the connection; a bad client id may be resent a few times.
+        is_rejected = !is_valid && (is_admin || ++it->second.attempts >= MAX_HANDSHAKE_ATTEMPTS);
+        if (is_valid || is_rejected) {
+            handshakes.erase(it);
+        }
+    }
 
-    closesocket(server_socket);
-    WSACleanup();
-}
+    if (is_valid) {
+        CompleteHandshake(connection, client_id, is_admin, codec, uses_opcodes);
+        return;
+    }
 
+    event_loop->Send(connection, json(ErrorMessageSendingClientIdS{Incorrect}).dump());
+    if (is_admin) {
+        std::cout << "Invalid Admin credentials...\n";
+    } else {
+        std::cout << "Invalid ID. Client must resend their ID...\n";
+    }
+    if (is_rejected) {
+        EventLoop::Close(connection);
+    }
+}
 
-// -----------------============HELPERS============----------------- //
-std::optional<json> Server::ReceiveAndParseResponse(const int client_socket, std::string &buffer) {
-    switch (RecvData(client_socket, buffer)) {
-        case DataStatus::DataReceived:
-            try {
-                return json::parse(buffer);
-            } catch (const json::parse_error &) {
-                std::cout << "JSON parse error\n";
-                return std::nullopt;
+void Server::CompleteHandshake(const std::shared_ptr<Connection> &connection, const size_t client_id,
+                               const bool is_admin, const Codec codec, const bool uses_opcodes) {
+    connection->id = client_id;
+    connection->is_identified.store(true, std::memory_order_release);
+
+    ClientThreadData *client = nullptr;
+    {
+        std::lock_guard lock(clients_mutex);
+        // Check if the client is already connected
+        if (clients.contains(client_id)) {
+            auto &client_data = clients[client_id];
+            if (const auto old_connection = client_data->GetConnection();
+                client_data->is_client_connected && old_connection) {
+                std::cout << "Client already connected. Closing previous connection.\n";
+                std::cout << "Old client socket: " << old_connection->socket << "\n";
+                std::cout << "New client socket: " << connection->socket << "\n";
+                EventLoop::Close(old_connection);
             }
+            client_data->SetConnection(connection, codec, uses_opcodes);
+            if (is_admin) {
+                client_data->is_admin = true;
+            }
+            client_data->is_client_connected = true;
+            client = client_data.get();
+        } else {
+            // Add new client
+            auto client_thread_data = std::make_unique<ClientThreadData>();
+            client_thread_data->id = client_id;
+            client_thread_data->is_admin = is_admin;
+            client_thread_data->SetConnection(connection, codec, uses_opcodes);
+            client_thread_data->is_client_connected = true;
+
+            client = client_thread_data.get();
+            clients[client_id] = std::move(client_thread_data);
+        }
+    }
+    ScheduleStatusProbes(client);
 
-        case DataStatus::DataNotReceived:
-            std::cout << "Data not received\n";
-            return std::nullopt;
-
-        case DataStatus::UnknownReceivedError:
-        default:
-            std::cout << "Unknown error while receiving data\n";
-            return std::nullopt;
+    json reply = ErrorMessageSendingClientIdS{Ok};
+    reply["codec"] = CodecName(codec);
+    if (uses_opcodes) {
+        reply["opcodes"] = action_registry.OpcodeNames();
     }
+    event_loop->Send(connection, reply.dump());
+    std::cout << "Client with id: " << client_id << " speaks " << CodecName(codec) << "\n";
 }
 
-void Server::ProcessClientAction(const size_t id, ClientThreadData *thread_data,
-                                 const Request &request,
-                                 const json &action_data) {
-    // Prepare buffer and send data
-    std::string buffer(1024, '\0');
-    switch (SendData(thread_data->client_socket, request.body)) {
-        case DataStatus::DataSent:
-            std::cerr << "Request sent to client with id: " << id << "\n";
-            break;
-        case DataStatus::DataNotSent:
-        case DataStatus::UnknownSentError:
-            std::cerr << "Error sending request to client with id: " << id << "\n";
-            thread_data->is_client_connected = false;
-            thread_data->update_status_time();
-            return;
-        default: break;
+ClientThreadData *Server::FindClient(const size_t client_id) {
+    std::lock_guard lock(clients_mutex);
+    const auto it = clients.find(client_id);
+    return it == clients.end() ? nullptr : it->second.get();
+}
+
+// Client records are never erased, so the pointers stay valid after the lock is released.
+std::vector<ClientThreadData *> Server::SnapshotClients() {
+    std::lock_guard lock(clients_mutex);
+    std::vector<ClientThreadData *> snapshot;
+    snapshot.reserve(clients.size());
+    for (const auto &client: clients | std::views::values) {
+        snapshot.push_back(client.get());
     }
+    return snapshot;
+}
 
-    // Receive and process response
-    const auto response_opt = ReceiveAndParseResponse(thread_data->client_socket, buffer);
-    if (!response_opt) {
-        std::cerr << "Failed to receive valid response from client with id: " << id << "\n";
-        thread_data->is_client_connected = false;
-        thread_data->update_status_time();
+
+// -----------------============HELPERS============----------------- //
+void Server::SendRequestAsync(ClientThreadData *thread_data, const size_t transaction_id, const uint16_t opcode,
+                              SharedPayload payload,
+                              const std::chrono::steady_clock::time_point deadline,
+                              InFlightTable::Completion on_response) {
+    if (!thread_data->in_flight.Insert(transaction_id, opcode, std::move(on_response))) {
+        std::cout << "Transaction " << transaction_id << " is already in flight for client with id: "
+                << thread_data->id << "\n";
         return;
     }
+    ScheduleTimer(RequestDeadline{thread_data, transaction_id}, deadline);
 
-    const json &response = response_opt.value();
-    if (Request::CompareRequests(request, response)) {
-        //std::cout << "PC status is up for client id: " << id << "\n";
-        thread_data->is_client_connected = true;
-    } else {
-        //std::cout << "PC status is down for client id: " << id << "\n";
-        thread_data->is_client_connected = true;
+    const auto connection = thread_data->GetConnection();
+    if (!connection || event_loop->Send(connection, std::move(payload)) != DataStatus::DataSent) {
+        thread_data->in_flight.Fail(transaction_id);
+    }
+}
+
+std::optional<Response> Server::SendRequestAndWait(ClientThreadData *thread_data, const size_t transaction_id,
+                                                   const uint16_t opcode, SharedPayload payload,
+                                                   const std::chrono::steady_clock::time_point deadline) {
+    auto response = std::make_shared<std::promise<std::optional<Response> > >();
+    auto future = response->get_future();
+    SendRequestAsync(thread_data, transaction_id, opcode, std::move(payload), deadline,
+                     [response](std::optional<Response> result) { response->set_value(std::move(result)); });
+
+    // The tick expires the entry on time; failing it here only matters once the event loop has stopped.
+    if (future.wait_until(deadline + EventLoop::TICK_INTERVAL) != std::future_status::ready) {
+        thread_data->in_flight.Fail(transaction_id);
+    }
+    return future.get();
+}
+
+void Server::ProcessClientAction(const size_t id, ClientThreadData *thread_data, const RequestTemplate &probe) {
+    // Only the id differs between probes, so it is patched into the pre-encoded template.
+    const size_t transaction_id = TransactionId::Next();
+    ++thread_data->probes_in_flight;
+    SendRequestAsync(thread_data, transaction_id, probe.Opcode(),
+                     probe.Instantiate(thread_data->codec, thread_data->uses_opcodes, transaction_id),
+                     std::chrono::steady_clock::now() + RESPONSE_TIMEOUT,
+                     [id, thread_data](const std::optional<Response> &response) {
+                         if (!response) {
+                             std::cerr << "Failed to receive valid response from client with id: " << id << "\n";
+                             // Probed again soon, to tell a hiccup from a client that is gone.
+                             thread_data->quiet_rounds = 0;
+                         }
+                         thread_data->is_client_connected = response.has_value();
+                         thread_data->update_status_time();
+                         --thread_data->probes_in_flight;
+                     });
+}
+
+void Server::ScheduleStatusProbes(ClientThreadData *client) {
+    const uint64_t schedule = ++client->probe_schedule;
+    client->quiet_rounds = 0;
+    constexpr auto interval = std::chrono::duration_cast<std::chrono::milliseconds>(PROBE_INTERVAL_MIN);
+    const auto offset = interval * static_cast<int64_t>(client->id % PROBE_SPREAD_STEPS) /
+                        static_cast<int64_t>(PROBE_SPREAD_STEPS);
+    ScheduleTimer(ProbeDue{client, schedule}, std::chrono::steady_clock::now() + offset);
+}
+
+std::chrono::steady_clock::duration Server::ProbeInterval(const ClientThreadData &client) {
+    constexpr auto max_doublings = std::bit_width(static_cast<uint64_t>(PROBE_INTERVAL_MAX / PROBE_INTERVAL_MIN));
+    const unsigned doublings = std::min<unsigned>(client.quiet_rounds, max_doublings);
+    return std::min<std::chrono::steady_clock::duration>(PROBE_INTERVAL_MIN * (int64_t{1} << doublings),
+                                                         PROBE_INTERVAL_MAX);
+}
+
+void Server::SendDueProbes(ClientThreadData *client) {
+    for (const auto &probe: status_probes) {
+        ProcessClientAction(client->id, client, probe);
     }
-    thread_data->update_status_time();
 }
 
 void Server::HandleClientAction(const size_t client_id, const Request &request) {
-    auto &[thread_data, _] = client_threads.at(client_id);
+    ClientThreadData *thread_data = FindClient(client_id);
+    if (thread_data == nullptr) {
+        std::cout << "Client not found\n";
+        return;
+    }
 
     if (!thread_data->is_client_connected) {
         std::cout << "Client is not connected\n";
         return;
     }
 
-    std::string buffer(1024, '\0');
-    switch (SendData(thread_data->client_socket, request.body)) {
-        case DataStatus::DataSent:
-            std::cout << "Request sent to client with id: " << thread_data->id << "\n";
-            break;
-
-        default:
-            std::cout << "Failed to send request to client with id: " << thread_data->id << "\n";
-            return;
-    }
-
-    auto response_opt = ReceiveAndParseResponse(thread_data->client_socket, buffer);
-    if (response_opt && Request::CompareRequests(request, response_opt.value())) {
-        std::cout << "Received valid response: " << response_opt.value() << "\n";
+    std::cout << "Sending request to client with id: " << thread_data->id << "\n";
+    if (auto response_opt = SendRequestAndWait(thread_data, request.transaction_id, request.opcode,
+                                               request.Payload(thread_data->codec, thread_data->uses_opcodes),
+                                               std::chrono::steady_clock::now() + RESPONSE_TIMEOUT)) {
+        std::cout << "Received valid response: " << DescribeResponse(*response_opt) << "\n";
     } else {
         std::cout << "Invalid or no response from client with id: " << thread_data->id << "\n";
     }
 }
 
 void Server::BroadcastAction(const Request &request, const json &action_data) {
-    for (auto &thread_pair: client_threads | std::views::values) {
-        HandleClientAction(thread_pair.first->id, request);
+    const auto deadline = std::chrono::steady_clock::now() + RESPONSE_TIMEOUT;
+
+    struct Collector {
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t remaining = 0;
+        size_t answered = 0;
+    };
+    const auto collector = std::make_shared<Collector>();
+
+    std::vector<ClientThreadData *> targets;
+    for (const auto client: SnapshotClients()) {
+        if (client->is_client_connected) {
+            targets.push_back(client);
+        }
     }
-}
-
-void Server::PrintAllActionsWithIndex(const Actions &actions) {
-    for (size_t index = 0; index < actions.size(); ++index) {
-        std::cout << index << ". " << actions[index]->getName() << "\n";
+    collector->remaining = targets.size();
+
+    for (const auto client: targets) {
+        // Encoded once per wire format; every send queue using that format references the same buffer.
+        const SharedPayload &payload = request.Payload(client->codec, client->uses_opcodes);
+        SendRequestAsync(client, request.transaction_id, request.opcode, payload, deadline,
+                         [collector, client](std::optional<Response> response) {
+                             if (response) {
+                                 std::cout << "Received valid response from client with id: " << client->id
+                                         << ": " << DescribeResponse(*response) << "\n";
+                             } else {
+                                 std::cout << "Invalid or no response from client with id: " << client->id << "\n";
+                             }
+
+                             std::lock_guard lock(collector->mutex);
+                             collector->answered += response.has_value();
+                             if (--collector->remaining == 0) {
+                                 collector->done.notify_all();
+                             }
+                         });
+    }
+    std::cout << "Request sent to " << targets.size() << " client(s)\n";
+
+    std::unique_lock lock(collector->mutex);
+    if (!collector->done.wait_until(lock, deadline + EventLoop::TICK_INTERVAL,
+                                    [&collector] { return collector->remaining == 0; })) {
+        // Only reached once the event loop has stopped expiring entries.
+        lock.unlock();
+        for (const auto client: targets) {
+            client->in_flight.Fail(request.transaction_id);
+        }
+        lock.lock();
     }
+    std::cout << collector->answered << "/" << targets.size() << " client(s) answered\n";
 }
 
+void Server::SendToChosenClients(const Request &request) {
+    std::cout << "Enter client id or 'all' to send to all clients\n";
+    for (const auto client: SnapshotClients()) {
+        std::cout << "Client id: " << client->id << "\n";
+    }
+    std::string input;
+    std::getline(std::cin, input);
 
-// ---------------------=============Action Management On Server=============--------------------- //
-void Server::HandleClient() {
-    while (true) {
-        std::cout << "Updating client status...\n";
-
-        std::lock_guard lock(admin_thread_mutex);
+    if (input == "all") {
+        BroadcastAction(request, request.message.value("data", json{}));
+        return;
+    }
+    size_t client_id = 0;
+    const auto [end, error] = std::from_chars(input.data(), input.data() + input.size(), client_id);
+    if (error != std::errc() || end != input.data() + input.size()) {
+        std::cout << "Invalid client id\n";
+        return;
+    }
+    const ClientThreadData *client = FindClient(client_id);
+    if (client == nullptr) {
+        std::cout << "Client not found\n";
+        return;
+    }
+    if (!client->is_client_connected) {
+        std::cout << "Client is not connected\n";
+        return;
+    }
+    HandleClientAction(client_id, request);
+}
 
-        for (auto &[id, thread_data_pair]: client_threads) {
-            auto data_ptr = thread_data_pair.first.get();
-            if (!data_ptr->is_client_connected) {
-                // std::cout << "Client with id :" << id << " is not connected\n";
-                continue;
-            }
-            for (const auto &action: action_registry.status_update_actions) {
-                Request request;
-                request.InitializeRequest(action->getName(), action->serialize());
-                ProcessClientAction(id, data_ptr, request, action->serialize());
+std::string Server::DescribeResponse(const Response &response) {
+    if (auto decoded = response.Json(DecodeResponseFields)) {
+        // Opcodes are for the wire; people read names.
+        if (const auto index = decoded->find("index"); index != decoded->end() && index->is_number_unsigned()) {
+            if (const auto action = action_registry.AtOpcode(index->get<uint16_t>())) {
+                *index = action->getName();
             }
         }
+        return decoded->dump();
+    }
+    return "<malformed " + std::string(CodecName(response.GetCodec())) + " payload>";
+}
+
+void Server::PrintClientStatuses() {
+    for (const auto client: SnapshotClients()) {
+        const PCStatus_S_OUT status = client->GetStatus();
+        std::cout << "Client " << client->id << (client->is_admin ? " (admin)" : "")
+                << (client->is_client_connected ? " connected" : " disconnected")
+                << ", ip: " << status.ip << ", mac: " << status.mac << ", os: " << status.os << "\n";
+    }
+}
 
-        std::this_thread::sleep_for(std::chrono::seconds(5));
+void Server::PrintAllActionsWithIndex(const Actions &actions) {
+    for (size_t index = 0; index < actions.size(); ++index) {
+        std::cout << index << ". " << actions[index]->getName() << "\n";
     }
 }
 
+
+// ---------------------=============Action Management On Server=============--------------------- //
 void Server::AdminThread(Server *server) {
     std::string input;
     std::cout << "Admin commands:\n";
     PrintAllActionsWithIndex(action_registry.client_actions);
 
     while (true) {
-        std::cout << "Enter action index or 'exit' to stop the server\n";
-        std::getline(std::cin, input);
+        std::cout << "Enter action index, 'batch' to send several actions at once, 'status' to list the clients "
+                "or 'exit' to stop the server\n";
+        if (!std::getline(std::cin, input)) {
+            // stdin closed: keep serving without the console.
+            break;
+        }
 
         if (input == "exit") {
             std::cout << "Are you sure you want to stop the server? (y/n)\n";
@@ -292,8 +648,9 @@ void Server::AdminThread(Server *server) {
         }
 
         if (!input.empty() && std::ranges::all_of(input, isdigit)) {
-            int actionIndex = std::stoi(input);
-            if (actionIndex < 0 || actionIndex >= action_registry.client_actions.size()) {
+            size_t actionIndex = 0;
+            const auto [end, error] = std::from_chars(input.data(), input.data() + input.size(), actionIndex);
+            if (error != std::errc() || actionIndex >= action_registry.client_actions.size()) {
                 std::cout << "Action not found\n";
                 continue;
             }
@@ -301,31 +658,35 @@ void Server::AdminThread(Server *server) {
             auto action = action_registry.client_actions[actionIndex];
             Request request;
             request.InitializeRequest(action->getName(), action->serialize());
-
-            std::cout << "Enter client id or 'all' to send to all clients\n";
-            for (const auto &thread_pair: client_threads | std::views::values | std::views::keys) {
-                std::cout << "Client id: " << thread_pair->id << "\n";
-            }
+            SendToChosenClients(request);
+        } else if (input == "status") {
+            PrintClientStatuses();
+        } else if (input == "batch") {
+            std::cout << "Run the actions one after the other, in order? (y/n)\n";
             std::getline(std::cin, input);
+            BatchBuilder batch(input == "y");
 
-            if (input == "all") {
-                BroadcastAction(request, action->serialize());
-            } else {
-                try {
-                    const size_t client_id = std::stoull(input);
-                    if (!client_threads.contains(client_id)) {
-                        std::cout << "Client not found\n";
-                        continue;
-                    }
-                    if (!client_threads[client_id].first->is_client_connected) {
-                        std::cout << "Client is not connected\n";
-                        continue;
-                    }
-                    HandleClientAction(client_id, request);
-                } catch (const std::invalid_argument &) {
-                    std::cout << "Invalid client id\n";
+            while (true) {
+                std::cout << "Enter action index to add, or an empty line to send the batch\n";
+                if (!std::getline(std::cin, input) || input.empty()) {
+                    break;
                 }
+                size_t action_index = 0;
+                const auto [end, error] = std::from_chars(input.data(), input.data() + input.size(), action_index);
+                if (error != std::errc() || end != input.data() + input.size() ||
+                    action_index >= action_registry.client_actions.size()) {
+                    std::cout << "Action not found\n";
+                    continue;
+                }
+                const auto &action = action_registry.client_actions[action_index];
+                batch.Add(action->getName(), action->serialize());
+            }
+
+            if (batch.Size() == 0) {
+                std::cout << "Batch is empty\n";
+                continue;
             }
+            SendToChosenClients(batch.Build());
         } else {
             std::cout << "Invalid command\n";
         }
@@ -1,4 +1,9 @@
 #pragma once
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <condition_variable>
+#include <future>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -6,6 +11,8 @@
 #include <queue>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <variant>
 #include <vector>
 
 
@@ -18,8 +25,13 @@
 #include <Actions/ActionStructures.h>
 #include <Actions/ActionSystem.h>
 #include <Networking/Networking.h>
+#include <Networking/EventLoop.h>
+#include <Networking/Envelope.h>
+#include <Networking/InFlightTable.h>
 #include <RequestBuilder/RequestBuilder.h>
 #include <Actions/Action.h>
+#include <Timing/TimingWheel.h>
+#include <Timing/TokenBucket.h>
 
 #pragma comment(lib, "Ws2_32.lib")
 
@@ -28,24 +40,123 @@ using json = nlohmann::json;
 struct ClientThreadData {
     size_t id{};
     bool is_admin = false;
-    SOCKET client_socket{};
 
-    PCStatus_S_OUT status;
-    bool is_client_connected = false;
+    std::atomic<bool> is_client_connected = false;
 
     size_t last_status_update_time = 0; // UNIX timestamp
 
     std::queue<int> action_queue;
 
+    /// \brief Requests sent on the current connection that still wait for a response.
+    InFlightTable in_flight;
+
+    /// \brief Payload encoding negotiated for the current connection.
+    std::atomic<Codec> codec{Codec::Json};
+
+    /// \brief Whether the current connection carries actions as opcodes rather than names.
+    std::atomic<bool> uses_opcodes{false};
+
+    /// \brief Bumped each time the client's probes are rescheduled, so older ProbeDue timers are recognised
+    /// as stale and dropped.
+    std::atomic<uint64_t> probe_schedule{0};
+
+    /// \brief Status probes sent to the client that have not completed yet.
+    std::atomic<size_t> probes_in_flight{0};
+
+    /// \brief Probe rounds sent since the client reconnected, failed a probe or last had other requests in
+    /// flight. Each one doubles the client's probe interval.
+    std::atomic<unsigned> quiet_rounds{0};
+
+    /// \brief When the client last pushed its status or a heartbeat (see STATUS_PUSH).
+    std::atomic<std::chrono::steady_clock::time_point> last_push{};
+
     void update_status_time() {
         last_status_update_time = static_cast<size_t>(std::chrono::system_clock::to_time_t(
             std::chrono::system_clock::now()));
     }
+
+    /// \brief The status the client last pushed.
+    PCStatus_S_OUT GetStatus() {
+        std::lock_guard lock(mutex);
+        return status;
+    }
+
+    /// \brief Applies a STATUS_PUSH and returns the status version held afterwards: the pushed one, or the
+    /// current one if the push is based on a version this record does not hold. Throws on a malformed push,
+    /// leaving the record as it was.
+    uint64_t ApplyStatusPush(const json &push) {
+        const auto version = push.at("version").get<uint64_t>();
+        const auto base = push.at("base").get<uint64_t>();
+        std::lock_guard lock(mutex);
+        if (base != 0 && base != status_version) {
+            return status_version;
+        }
+        PCStatus_S_OUT updated = base == 0 ? PCStatus_S_OUT{} : status;
+        ApplyJsonFields(push.at("fields"), updated);
+        status = std::move(updated);
+        status_version = version;
+        return status_version;
+    }
+
+    uint64_t GetStatusVersion() {
+        std::lock_guard lock(mutex);
+        return status_version;
+    }
+
+    std::shared_ptr<Connection> GetConnection() {
+        std::lock_guard lock(mutex);
+        return connection;
+    }
+
+    /// \brief Requests still in flight on the previous connection can no longer be answered and fail.
+    void SetConnection(std::shared_ptr<Connection> new_connection, const Codec new_codec = Codec::Json,
+                       const bool new_uses_opcodes = false) {
+        {
+            std::lock_guard lock(mutex);
+            codec = new_codec;
+            uses_opcodes = new_uses_opcodes;
+            connection = std::move(new_connection);
+        }
+        in_flight.FailAll();
+    }
+
+private:
+    std::mutex mutex;
+    std::shared_ptr<Connection> connection;
+    PCStatus_S_OUT status;
+    uint64_t status_version = 0;
+};
+
+// ----=== Server timers ===----
+/// \brief The connection is dropped if it has not identified itself by now.
+struct HandshakeDeadline {
+    std::weak_ptr<Connection> connection;
+};
+
+/// \brief The request fails if it has not been answered by now.
+struct RequestDeadline {
+    ClientThreadData *client;
+    size_t transaction_id;
+};
+
+/// \brief The client's next round of status probes is due. `schedule` is the client's probe_schedule when
+/// it was scheduled.
+struct ProbeDue {
+    ClientThreadData *client;
+    uint64_t schedule;
+};
+
+using ServerTimer = std::variant<HandshakeDeadline, RequestDeadline, ProbeDue>;
+
+/// \brief Accepted connection that has not sent a valid id yet. Its deadline is the HandshakeDeadline timer.
+struct PendingHandshake {
+    std::shared_ptr<Connection> connection;
+    unsigned attempts = 0;
 };
 
 class Server {
 public:
-    Server();
+    explicit Server(EventLoopBackend backend = EventLoopBackend::Epoll);
 
     ~Server();
 
@@ -57,34 +168,140 @@ public:
 
     void EndServer();
 
-    void HandleClient();
-
     void AdminThread(Server *server);
 
     //---------============ HELPERS============---------//
-    static std::optional<json> ReceiveAndParseResponse(int client_socket, std::string &buffer);
+    /// \brief Registers the request in the client's in-flight table and queues it. `on_response` runs once, on
+    /// an event loop worker, with the response or with std::nullopt on timeout or disconnect. Never blocks.
+    void SendRequestAsync(ClientThreadData *thread_data, size_t transaction_id, uint16_t opcode,
+                          SharedPayload payload, std::chrono::steady_clock::time_point deadline,
+                          InFlightTable::Completion on_response);
+
+    /// \brief Blocking wrapper around SendRequestAsync. Other requests to the same client may be in flight meanwhile.
+    std::optional<Response> SendRequestAndWait(ClientThreadData *thread_data, size_t transaction_id,
+                                               uint16_t opcode, SharedPayload payload,
+                                               std::chrono::steady_clock::time_point deadline);
 
-    static void ProcessClientAction(size_t id, ClientThreadData *thread_data, const Request &request,
-                                    const json &action_data);
+    /// \brief Sends one status probe and records whether the client answered once the response arrives.
+    /// Never blocks.
+    void ProcessClientAction(size_t id, ClientThreadData *thread_data, const RequestTemplate &probe);
 
     void HandleClientAction(size_t client_id, const Request &request);
 
+    /// \brief Queues one shared copy of the request on every connected client and collects the responses
+    /// as they arrive, against a single deadline, so the whole fleet costs about one round trip.
     void BroadcastAction(const Request &request, const json &action_data);
 
+    /// \brief Asks the admin for a client id or 'all' and sends the request there.
+    void SendToChosenClients(const Request &request);
+
 public:
     ActionFactory actionFactory;
     SOCKET server_socket{};
     sockaddr_in serverAddr{};
     int PORT = 54000;
-    bool isRunning = false;
+    std::atomic<bool> isRunning = false;
 
     std::string admin_secret = "admin:admin";
 
+    static constexpr auto RESPONSE_TIMEOUT = std::chrono::seconds(5);
+    /// \brief Probe interval of a client that just connected, failed a probe or is running requests.
+    static constexpr auto PROBE_INTERVAL_MIN = std::chrono::seconds(2);
+
+    /// \brief Probe interval a stable, idle client backs off to.
+    static constexpr auto PROBE_INTERVAL_MAX = std::chrono::minutes(5);
+
+    /// \brief A client that pushed its status or a heartbeat within this long is not probed.
+    static constexpr auto PUSH_TIMEOUT = HEARTBEAT_INTERVAL + PROBE_INTERVAL_MIN;
+
+    /// \brief First probes are spread over this many steps of PROBE_INTERVAL_MIN.
+    static constexpr size_t PROBE_SPREAD_STEPS = 64;
+
+    /// \brief Status probes per second for the whole fleet. Rounds over the budget wait for the next tick.
+    size_t probe_budget = 1000;
+
+    /// \brief Time a new connection gets to identify itself before it is dropped.
+    static constexpr auto HANDSHAKE_TIMEOUT = std::chrono::seconds(10);
+    static constexpr unsigned MAX_HANDSHAKE_ATTEMPTS = 5;
+
 protected:
     std::thread adminThread;
-    std::mutex admin_thread_mutex;
 
-    std::map<size_t, std::pair<std::unique_ptr<ClientThreadData>, std::thread> > client_threads;
+    /// \brief Owns every client socket. Frames are routed to the client's inbox by id.
+    std::unique_ptr<EventLoop> event_loop;
+
+    /// \brief Guards the clients map itself. Never held across network I/O.
+    std::mutex clients_mutex;
+    std::map<size_t, std::unique_ptr<ClientThreadData> > clients;
+
+    /// \brief Lets StartServer sleep until EndServer is called.
+    std::mutex shutdown_mutex;
+    std::condition_variable shutdown_cv;
+
+    /// \brief Connections still in the handshake, keyed by the connection itself.
+    std::mutex handshakes_mutex;
+    std::unordered_map<const Connection *, PendingHandshake> handshakes;
+
+    /// \brief Every deadline the server keeps: handshakes, requests and status probes. Advanced by the event
+    /// loop's tick, so no thread sleeps on a deadline. Timers whose work already happened (a request that
+    /// was answered, a handshake that completed) are left in place and do nothing when they fire.
+    std::mutex timers_mutex;
+    TimingWheel<ServerTimer> timers{EventLoop::TICK_INTERVAL};
+
+    /// \brief Adds a timer. Safe to call from any thread.
+    void ScheduleTimer(ServerTimer timer, std::chrono::steady_clock::time_point deadline);
+
+    /// \brief Status probes, encoded once when the server starts.
+    std::vector<RequestTemplate> status_probes;
+
+    /// \brief Spends the fleet's probe budget. Only touched by OnTick. Set up in StartServer.
+    std::optional<TokenBucket> probe_tokens;
+
+    /// \brief Stops the event loop. Runs on the thread that called StartServer.
+    void ReleaseResources();
+
+    ClientThreadData *FindClient(size_t client_id);
+
+    std::vector<ClientThreadData *> SnapshotClients();
+
+    void OnFrame(const std::shared_ptr<Connection> &connection, std::string_view frame);
+
+    /// \brief Applies a STATUS_PUSH or HEARTBEAT the client sent unprompted. A push is answered with a STATUS_ACK.
+    void OnPush(ClientThreadData *client, const MessageEnvelope &envelope);
+
+    /// \brief Prints every client's connection state and last pushed status.
+    void PrintClientStatuses();
+
+    /// \brief FieldsDecoder for responses on binary connections.
+    static bool DecodeResponseFields(const BinaryEnvelope &envelope, BinaryReader &reader, json &out);
+
+    /// \brief Decodes a response for printing.
+    static std::string DescribeResponse(const Response &response);
+
+    void OnConnectionClosed(const std::shared_ptr<Connection> &connection);
+
+    void OnAccept(const std::shared_ptr<Connection> &connection);
+
+    /// \brief Drops connections whose handshake deadline has passed, expires timed-out requests and sends
+    /// the status probes that are due. Runs on the event loop's tick.
+    void OnTick();
+
+    /// \brief Starts a new probe schedule for the client, replacing any earlier one. The first probe is
+    /// spread over PROBE_INTERVAL_MIN by client id, so clients that connect together are not probed together.
+    void ScheduleStatusProbes(ClientThreadData *client);
+
+    /// \brief Sends the probes of a client whose turn has come.
+    void SendDueProbes(ClientThreadData *client);
+
+    /// \brief Time until the client's next probe round, from how long it has been quiet.
+    static std::chrono::steady_clock::duration ProbeInterval(const ClientThreadData &client);
+
+    /// \brief Handles a frame from a connection that has not identified itself yet.
+    void ProcessHandshake(const std::shared_ptr<Connection> &connection, std::string_view frame);
+
+    /// \brief Binds an identified connection to its client record and confirms the id.
+    void CompleteHandshake(const std::shared_ptr<Connection> &connection, size_t client_id, bool is_admin,
+                           Codec codec, bool uses_opcodes);
 
     using Actions = std::vector<std::shared_ptr<Action> >;
 